@@ -0,0 +1,268 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+// Project includes
+#include "CMAESCmd.hpp"
+#include <CMAES.hpp>
+#include <FFNN.hpp>
+#include <Kernels.hpp>
+#include <RandomStream.hpp>
+#include <SnakeSimulator.hpp>
+// External includes
+// System includes
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+
+namespace sai::cmd
+{
+
+void CMAESCmd::Run(int argc, const char *argv[])
+{
+    static const char USAGE[] =
+    R"(
+    Snake AI - Copyright (c) 2023-Present, Arkin Terli. All rights reserved.
+
+    Usage:
+        SnakeAIApp cmaes train --modelfile=<name> [--bw=<number> --bh=<number>] [--lambda=<number>]
+                                                  [--sigma=<number>] [--cov=<model>] [--sc=<number>]
+                                                  [--maxGen=<number>] [--eval=<mode>] [--lutmax=<number>]
+                                                  [--seed=<number>]
+
+    Options:
+
+        --modelfile=<name>      Model filename. Use 'SnakeAIApp ga play' to play trained models.
+
+        --bw=<number>           Board width in block units.  [Default: 10]
+        --bh=<number>           Board height in block units. [Default: 10]
+
+        --lambda=number         Number of candidates per generation. 0 selects 4 + 3 ln(model parameters).
+                                [Default: 0]
+        --sigma=number          Initial step size. [Default: 0.5]
+        --cov=model             Covariance model: sep, full. sep adapts only the variances of the parameters and
+                                is much cheaper. full also learns correlations between parameters. [Default: sep]
+        --sc=number             Model sampling count per generation. [Default: 2000]
+        --maxGen=number         Maximum number of generation for training. [Default: 1000]
+        --eval=mode             Fitness evaluation mode: single, lut. [Default: single]
+        --lutmax=number         Maximum policy lookup table size (KB) in lut evaluation mode. Models are not
+                                compiled into tables on boards that need larger tables. [Default: 1024]
+        --seed=number           Seed of the training run. Runs with the same seed and parameters are identical.
+                                A random seed is used if not given.
+    )";
+
+    std::map <std::string, docopt::value>  args;
+
+    try
+    {
+        // Parse cmd-line parameters.
+        args = docopt::docopt(USAGE, {argv + 1, argv + argc}, false, "SnakeAIApp 1.0.0");
+    }
+    catch (...)
+    {
+        std::cerr << "Invalid commandline parameter usage. Please use '--help' parameter for more information."
+                  << std::endl;
+        return;
+    }
+
+    if (!ValidateArguments(args, USAGE))
+    {
+        return;
+    }
+
+    // Execute the command.
+    ExecuteCommand(args);
+}
+
+
+bool CMAESCmd::ValidateArguments(std::map <std::string, docopt::value>& args, const char* USAGE)
+{
+    // Show help if necessary
+    if (args["-h"] || args["--help"])
+    {
+        std::cout << USAGE << std::endl;
+        return false;
+    }
+
+    auto CheckRangeLong = [&](const std::string& paramName, int min, int max) -> bool
+    {
+        if (args[paramName] && (args[paramName].asLong() < min || args[paramName].asLong() > max))
+        {
+            std::cout << "Invalid parameter range: " << paramName
+                      << " must be in [" << min << "," << max << "]" << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+    // VALIDATE ARGUMENTS
+
+    if (!CheckRangeLong("--bw",  10, 100) ||
+        !CheckRangeLong("--bh",  10, 100) ||
+        !CheckRangeLong("--lambda", 0, 100000) ||
+        !CheckRangeLong("--sc",  1, 1000000)  ||
+        !CheckRangeLong("--maxGen", 1, 1000000) ||
+        !CheckRangeLong("--lutmax", 0, 1048576))
+    {
+        return false;
+    }
+
+    if (args["--bw"] && args["--bh"] && args["--sc"] &&
+        SnakeScenarioBank::GetMemorySize(args["--bw"].asLong(), args["--bh"].asLong(), args["--sc"].asLong()) >
+        SnakeScenarioBank::kMaxMemorySize)
+    {
+        std::cout << "Invalid --sc value. Games of the board size need more than "
+                  << SnakeScenarioBank::kMaxMemorySize / (1024 * 1024) << " MB." << std::endl;
+        return false;
+    }
+
+    if (args["--lambda"] && args["--lambda"].asLong() == 1)
+    {
+        std::cout << "Invalid --lambda value. It must be 0 or at least 2." << std::endl;
+        return false;
+    }
+
+    if (args["--sigma"])
+    {
+        double sigma = 0;
+        try
+        {
+            sigma = std::stod(args["--sigma"].asString());
+        }
+        catch (...)
+        {
+        }
+
+        if (!(sigma > 0))
+        {
+            std::cout << "Invalid --sigma value. It must be a positive number." << std::endl;
+            return false;
+        }
+    }
+
+    if (args["--cov"] && args["--cov"].asString() != "sep" && args["--cov"].asString() != "full")
+    {
+        std::cout << "Invalid --cov value. It must be sep or full." << std::endl;
+        return false;
+    }
+
+    if (args["--eval"] && args["--eval"].asString() != "single" && args["--eval"].asString() != "lut")
+    {
+        std::cout << "Invalid --eval value. It must be single or lut." << std::endl;
+        return false;
+    }
+
+    if (args["--seed"] && args["--seed"].asLong() < 0)
+    {
+        std::cout << "Invalid --seed value. It must be a non-negative number." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+void CMAESCmd::ExecuteCommand(std::map <std::string, docopt::value> & args)
+{
+    std::string  modelFilename = args["--modelfile"].asString();
+
+    // Override parameters here
+    if (args["--bw"])  m_boardWidth  = args["--bw"].asLong();
+    if (args["--bh"])  m_boardHeight = args["--bh"].asLong();
+    if (args["--lambda"]) m_sampleCount = args["--lambda"].asLong();
+    if (args["--sigma"]) m_sigma = std::stod(args["--sigma"].asString());
+    if (args["--cov"] && args["--cov"].asString() == "full")
+    {
+        m_covarianceModel = es::CovarianceModel::kCovarianceModelFull;
+    }
+    if (args["--sc"])  m_samplingSize  = args["--sc"].asLong();
+    if (args["--maxGen"]) m_maxGeneration = args["--maxGen"].asLong();
+    if (args["--eval"]) m_usePolicyTable = args["--eval"].asString() == "lut";
+    if (args["--lutmax"]) m_policyTableBudget = args["--lutmax"].asLong();
+    if (args["--seed"])
+    {
+        m_seed = args["--seed"].asLong();
+    }
+    else
+    {
+        std::random_device rndDev;
+        m_seed = ((static_cast<uint64_t>(rndDev()) << 32) | rndDev()) >> 1;
+    }
+
+    if (args["train"].asBool())
+    {
+        TrainModel(modelFilename);
+    }
+}
+
+
+void CMAESCmd::TrainModel(const std::string & modelFilename)
+{
+    double bestFitness = -std::numeric_limits<double>::max();
+
+    // Games are seeded from the same stream as in the genetic algorithm training, so both trainers play the same
+    // games for the same seed.
+    ga::RandomStream  seedRng(m_seed, std::numeric_limits<uint32_t>::max(), 0);
+    SnakeSimulator  simulator(m_boardWidth, m_boardHeight, m_samplingSize, seedRng());
+    if (m_usePolicyTable)
+    {
+        simulator.SetPolicyTableBudget(m_policyTableBudget);
+    }
+
+    auto parameterCount = SnakeSimulator::GetParameterCount();
+
+    es::CMAES  cmaes(parameterCount, m_sampleCount, m_sigma, m_covarianceModel);
+    cmaes.SetSeed(m_seed);
+
+    // The initial mean is drawn from the same range as the initial genes of the genetic algorithm.
+    ga::RandomStream  meanRng(m_seed, std::numeric_limits<uint32_t>::max(), 1);
+    std::vector<double>  mean(parameterCount);
+    for (auto & value : mean)
+    {
+        value = meanRng.Uniform(-1, 1);
+    }
+    cmaes.SetMean(mean);
+
+    // This method will calculate fitness values of all candidates of a generation.
+    cmaes.SetPopulationFitnessFunc([&](const std::vector<std::span<const double>> & candidates,
+                                       ThreadPool & threadPool) -> std::vector<double>
+    {
+        return simulator.SimulateSnakeGames(candidates, threadPool);
+    });
+
+    cmaes.CreateInitialPopulation();
+
+    std::cout << "CPU Kernels: " << kernels::GetKernels().name << "\n";
+    std::cout << "Seed: " << m_seed << "\n";
+    std::cout << "Total Model Parameters: " << parameterCount << "\n";
+    std::cout << "Candidates per Generation: " << cmaes.GetSampleCount() << "\n";
+
+    while (cmaes.GetGeneration() < m_maxGeneration)
+    {
+        double fitness = cmaes.GetBestFitness();
+
+        // Save the best model.
+        if (fitness > bestFitness)
+        {
+            auto ffnn = SnakeSimulator::CreateFFNN();
+            ffnn.DeserializeAllParameters(cmaes.GetBestSolution());
+            ffnn.Save(modelFilename);
+
+            bestFitness = fitness;
+        }
+
+        std::cout << "Generation: " << cmaes.GetGeneration() << "  Fitness: " << bestFitness
+                  << "  Sigma: " << cmaes.GetSigma() << "\n";
+
+        cmaes.CreateNextPopulation();
+    }
+}
+
+}
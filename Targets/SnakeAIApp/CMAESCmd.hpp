@@ -0,0 +1,59 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#pragma once
+
+// Project includes
+#include "BaseCmd.hpp"
+#include "CMAES.hpp"
+// External includes
+#include <docopt/docopt.h>
+// System includes
+#include <map>
+
+
+namespace sai::cmd
+{
+
+// Trains snake models with CMA-ES. Models are compatible with the genetic algorithm models.
+class CMAESCmd : public BaseCmd
+{
+public:
+    // Constructor
+    CMAESCmd() = default;
+
+    // Destructor
+    virtual ~CMAESCmd() = default;
+
+    void Run(int argc, const char * argv[]) final;
+
+protected:
+    // Validate required arguments.
+    bool ValidateArguments(std::map<std::string, docopt::value> & args, const char * USAGE);
+
+    // Executes the command based on the given commandline parameter options.
+    void ExecuteCommand(std::map<std::string, docopt::value> & args);
+
+    void TrainModel(const std::string & modelFilename);
+
+private:
+    int m_boardWidth{10};
+    int m_boardHeight{10};
+
+    std::size_t m_sampleCount{0};
+    double      m_sigma{0.5};
+    es::CovarianceModel  m_covarianceModel{es::CovarianceModel::kCovarianceModelSeparable};
+    std::size_t m_samplingSize{2000};
+    std::size_t m_maxGeneration{1000};
+    bool        m_usePolicyTable{false};
+    std::size_t m_policyTableBudget{1024};    // In KB.
+    uint64_t    m_seed{0};
+};
+
+}
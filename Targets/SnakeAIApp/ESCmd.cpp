@@ -0,0 +1,261 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+// Project includes
+#include "ESCmd.hpp"
+#include <EvolutionStrategy.hpp>
+#include <FFNN.hpp>
+#include <Kernels.hpp>
+#include <RandomStream.hpp>
+#include <SnakeSimulator.hpp>
+// External includes
+// System includes
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+
+namespace sai::cmd
+{
+
+void ESCmd::Run(int argc, const char *argv[])
+{
+    static const char USAGE[] =
+    R"(
+    Snake AI - Copyright (c) 2023-Present, Arkin Terli. All rights reserved.
+
+    Usage:
+        SnakeAIApp es train --modelfile=<name> [--bw=<number> --bh=<number>] [--pairs=<number>]
+                                               [--sigma=<number>] [--lr=<number>] [--noise=<number>]
+                                               [--sc=<number>] [--maxGen=<number>] [--eval=<mode>]
+                                               [--lutmax=<number>] [--seed=<number>]
+
+    Options:
+
+        --modelfile=<name>      Model filename. Use 'SnakeAIApp ga play' to play trained models.
+
+        --bw=<number>           Board width in block units.  [Default: 10]
+        --bh=<number>           Board height in block units. [Default: 10]
+
+        --pairs=number          Number of antithetic candidate pairs per generation. [Default: 100]
+        --sigma=number          Standard deviation of the parameter noise. [Default: 0.1]
+        --lr=number             Learning rate of the Adam optimizer. [Default: 0.03]
+        --noise=number          Size of the shared noise table in millions of values. [Default: 16]
+        --sc=number             Model sampling count per generation. [Default: 2000]
+        --maxGen=number         Maximum number of generation for training. [Default: 1000]
+        --eval=mode             Fitness evaluation mode: single, lut. [Default: single]
+        --lutmax=number         Maximum policy lookup table size (KB) in lut evaluation mode. Models are not
+                                compiled into tables on boards that need larger tables. [Default: 1024]
+        --seed=number           Seed of the training run. Runs with the same seed and parameters are identical.
+                                A random seed is used if not given.
+    )";
+
+    std::map <std::string, docopt::value>  args;
+
+    try
+    {
+        // Parse cmd-line parameters.
+        args = docopt::docopt(USAGE, {argv + 1, argv + argc}, false, "SnakeAIApp 1.0.0");
+    }
+    catch (...)
+    {
+        std::cerr << "Invalid commandline parameter usage. Please use '--help' parameter for more information."
+                  << std::endl;
+        return;
+    }
+
+    if (!ValidateArguments(args, USAGE))
+    {
+        return;
+    }
+
+    // Execute the command.
+    ExecuteCommand(args);
+}
+
+
+bool ESCmd::ValidateArguments(std::map <std::string, docopt::value>& args, const char* USAGE)
+{
+    // Show help if necessary
+    if (args["-h"] || args["--help"])
+    {
+        std::cout << USAGE << std::endl;
+        return false;
+    }
+
+    auto CheckRangeLong = [&](const std::string& paramName, int min, int max) -> bool
+    {
+        if (args[paramName] && (args[paramName].asLong() < min || args[paramName].asLong() > max))
+        {
+            std::cout << "Invalid parameter range: " << paramName
+                      << " must be in [" << min << "," << max << "]" << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+    auto CheckPositiveDouble = [&](const std::string& paramName) -> bool
+    {
+        if (!args[paramName])
+        {
+            return true;
+        }
+
+        double value = 0;
+        try
+        {
+            value = std::stod(args[paramName].asString());
+        }
+        catch (...)
+        {
+        }
+
+        if (!(value > 0))
+        {
+            std::cout << "Invalid " << paramName << " value. It must be a positive number." << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+    // VALIDATE ARGUMENTS
+
+    if (!CheckRangeLong("--bw",  10, 100) ||
+        !CheckRangeLong("--bh",  10, 100) ||
+        !CheckRangeLong("--pairs", 1, 10000000) ||
+        !CheckRangeLong("--noise", 1, 4096) ||
+        !CheckRangeLong("--sc",  1, 1000000)  ||
+        !CheckRangeLong("--maxGen", 1, 1000000) ||
+        !CheckRangeLong("--lutmax", 0, 1048576) ||
+        !CheckPositiveDouble("--sigma") ||
+        !CheckPositiveDouble("--lr"))
+    {
+        return false;
+    }
+
+    if (args["--bw"] && args["--bh"] && args["--sc"] &&
+        SnakeScenarioBank::GetMemorySize(args["--bw"].asLong(), args["--bh"].asLong(), args["--sc"].asLong()) >
+        SnakeScenarioBank::kMaxMemorySize)
+    {
+        std::cout << "Invalid --sc value. Games of the board size need more than "
+                  << SnakeScenarioBank::kMaxMemorySize / (1024 * 1024) << " MB." << std::endl;
+        return false;
+    }
+
+    if (args["--eval"] && args["--eval"].asString() != "single" && args["--eval"].asString() != "lut")
+    {
+        std::cout << "Invalid --eval value. It must be single or lut." << std::endl;
+        return false;
+    }
+
+    if (args["--seed"] && args["--seed"].asLong() < 0)
+    {
+        std::cout << "Invalid --seed value. It must be a non-negative number." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+
+void ESCmd::ExecuteCommand(std::map <std::string, docopt::value> & args)
+{
+    std::string  modelFilename = args["--modelfile"].asString();
+
+    // Override parameters here
+    if (args["--bw"])  m_boardWidth  = args["--bw"].asLong();
+    if (args["--bh"])  m_boardHeight = args["--bh"].asLong();
+    if (args["--pairs"]) m_pairCount = args["--pairs"].asLong();
+    if (args["--sigma"]) m_sigma = std::stod(args["--sigma"].asString());
+    if (args["--lr"]) m_learningRate = std::stod(args["--lr"].asString());
+    if (args["--noise"]) m_noiseTableSize = args["--noise"].asLong();
+    if (args["--sc"])  m_samplingSize  = args["--sc"].asLong();
+    if (args["--maxGen"]) m_maxGeneration = args["--maxGen"].asLong();
+    if (args["--eval"]) m_usePolicyTable = args["--eval"].asString() == "lut";
+    if (args["--lutmax"]) m_policyTableBudget = args["--lutmax"].asLong();
+    if (args["--seed"])
+    {
+        m_seed = args["--seed"].asLong();
+    }
+    else
+    {
+        std::random_device rndDev;
+        m_seed = ((static_cast<uint64_t>(rndDev()) << 32) | rndDev()) >> 1;
+    }
+
+    if (args["train"].asBool())
+    {
+        TrainModel(modelFilename);
+    }
+}
+
+
+void ESCmd::TrainModel(const std::string & modelFilename)
+{
+    double bestFitness = -std::numeric_limits<double>::max();
+
+    // Games are seeded from the same stream as in the genetic algorithm training, so all trainers play the same
+    // games for the same seed.
+    ga::RandomStream  seedRng(m_seed, std::numeric_limits<uint32_t>::max(), 0);
+    SnakeSimulator  simulator(m_boardWidth, m_boardHeight, m_samplingSize, seedRng());
+    if (m_usePolicyTable)
+    {
+        simulator.SetPolicyTableBudget(m_policyTableBudget);
+    }
+
+    auto parameterCount = SnakeSimulator::GetParameterCount();
+
+    es::EvolutionStrategy  evolutionStrategy(parameterCount, m_pairCount, m_sigma, m_learningRate,
+                                             m_noiseTableSize * 1000000);
+    evolutionStrategy.SetSeed(m_seed);
+
+    // The initial mean is drawn from the same range as the initial genes of the genetic algorithm.
+    ga::RandomStream  meanRng(m_seed, std::numeric_limits<uint32_t>::max(), 1);
+    std::vector<double>  mean(parameterCount);
+    for (auto & value : mean)
+    {
+        value = meanRng.Uniform(-1, 1);
+    }
+    evolutionStrategy.SetMean(mean);
+
+    // This method will calculate fitness value for each candidate.
+    evolutionStrategy.SetFitnessFunc([&](std::span<const double> candidate) -> double
+    {
+        return simulator.SimulateSnakeGames(candidate);
+    });
+
+    evolutionStrategy.CreateInitialPopulation();
+
+    std::cout << "CPU Kernels: " << kernels::GetKernels().name << "\n";
+    std::cout << "Seed: " << m_seed << "\n";
+    std::cout << "Total Model Parameters: " << parameterCount << "\n";
+    std::cout << "Candidates per Generation: " << evolutionStrategy.GetSampleCount() << "\n";
+
+    while (evolutionStrategy.GetGeneration() < m_maxGeneration)
+    {
+        double fitness = evolutionStrategy.GetBestFitness();
+
+        // Save the best model.
+        if (fitness > bestFitness)
+        {
+            auto ffnn = SnakeSimulator::CreateFFNN();
+            ffnn.DeserializeAllParameters(evolutionStrategy.GetBestSolution());
+            ffnn.Save(modelFilename);
+
+            bestFitness = fitness;
+        }
+
+        std::cout << "Generation: " << evolutionStrategy.GetGeneration() << "  Fitness: " << bestFitness << "\n";
+
+        evolutionStrategy.CreateNextPopulation();
+    }
+}
+
+}
@@ -0,0 +1,60 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#pragma once
+
+// Project includes
+#include "BaseCmd.hpp"
+#include "EvolutionStrategy.hpp"
+// External includes
+#include <docopt/docopt.h>
+// System includes
+#include <map>
+
+
+namespace sai::cmd
+{
+
+// Trains snake models with evolution strategies. Models are compatible with the genetic algorithm models.
+class ESCmd : public BaseCmd
+{
+public:
+    // Constructor
+    ESCmd() = default;
+
+    // Destructor
+    virtual ~ESCmd() = default;
+
+    void Run(int argc, const char * argv[]) final;
+
+protected:
+    // Validate required arguments.
+    bool ValidateArguments(std::map<std::string, docopt::value> & args, const char * USAGE);
+
+    // Executes the command based on the given commandline parameter options.
+    void ExecuteCommand(std::map<std::string, docopt::value> & args);
+
+    void TrainModel(const std::string & modelFilename);
+
+private:
+    int m_boardWidth{10};
+    int m_boardHeight{10};
+
+    std::size_t m_pairCount{100};
+    double      m_sigma{0.1};
+    double      m_learningRate{0.03};
+    std::size_t m_noiseTableSize{16};     // In millions of values.
+    std::size_t m_samplingSize{2000};
+    std::size_t m_maxGeneration{1000};
+    bool        m_usePolicyTable{false};
+    std::size_t m_policyTableBudget{1024};    // In KB.
+    uint64_t    m_seed{0};
+};
+
+}
@@ -9,24 +9,152 @@
 
 // Project includes
 #include "GACmd.hpp"
+#include "TrainingMetrics.hpp"
+#include <AllocCounters.hpp>
+#include <BatchedFFNN.hpp>
+#include <EvaluationResult.hpp>
 #include <FFNN.hpp>
 #include <FontSFNSMono.hpp>
 #include <GeneticAlgorithm.hpp>
+#include <Kernels.hpp>
+#include <PerfCounters.hpp>
+#include <RandomStream.hpp>
 #include <SnakeGame.hpp>
+#include <RemoteEvaluation.hpp>
+#include <SnakeSimulator.hpp>
+#include <Trace.hpp>
+#include <WorkerProcessPool.hpp>
 // External includes
 #include <SFML/Graphics.hpp>
 #include <SFML/System.hpp>
 // System includes
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
 #include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 
 namespace sai::cmd
 {
 
+namespace
+{
+
+// Identifies training checkpoint files and their format version. The version must be increased whenever the layout
+// changes, so checkpoints of other versions are rejected instead of being misread.
+// Version 2 adds the evolution mode and the racing parameters.
+constexpr char  kCheckpointMagic[8] = {'S', 'A', 'I', 'C', 'K', 'P', 'T', '2'};
+
+// Set by the SIGTERM handler to stop the training after the current generation.
+volatile std::sig_atomic_t  g_terminateRequested = 0;
+
+// Writes the data into the file through a temporary file that replaces the file only after the data is on disk, so
+// neither an interrupted write nor a power loss leaves a truncated file behind. Returns false on failure.
+bool WriteFileAtomically(const std::string & filename, const std::string & data)
+{
+    std::string  tempFilename = filename + ".tmp";
+
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = open(tempFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    bool written = true;
+    for (std::size_t offset=0; written && offset<data.size(); )
+    {
+        auto size = write(fd, data.data() + offset, data.size() - offset);
+        written = size > 0;
+        offset += written ? static_cast<std::size_t>(size) : 0;
+    }
+
+    // The data must be on disk before the rename, otherwise the renamed file can be empty after a crash.
+    written = written && fsync(fd) == 0;
+    written = close(fd) == 0 && written;
+    if (!written || rename(tempFilename.c_str(), filename.c_str()) != 0)
+    {
+        unlink(tempFilename.c_str());
+        return false;
+    }
+
+    // The rename itself is on disk only after the directory is synced.
+    auto directory = std::filesystem::path(filename).parent_path();
+    int dirFd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (dirFd >= 0)
+    {
+        fsync(dirFd);
+        close(dirFd);
+    }
+    return true;
+#else
+    {
+        std::ofstream  file(tempFilename, std::ios::binary);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        file.close();
+        if (!file)
+        {
+            std::filesystem::remove(tempFilename);
+            return false;
+        }
+    }
+
+    std::error_code  errorCode;
+    std::filesystem::rename(tempFilename, filename, errorCode);
+    if (errorCode)
+    {
+        std::filesystem::remove(tempFilename, errorCode);
+        return false;
+    }
+    return true;
+#endif
+}
+
+// Plays all games with the model and returns its fitness value together with the counters of the games and the
+// allocations of the calling thread. Used where the counters of the simulator are not visible to the trainer.
+EvaluationResult EvaluateWithCounters(const SnakeSimulator & simulator, std::span<const double> chromosome)
+{
+    auto allocCounts = AllocCounters::GetThreadCounts();
+    auto stats = simulator.SimulateSnakeGameRange(chromosome, 0, simulator.GetGameCount());
+    return {stats.GetFitness(), stats.games, stats.gameSteps, stats.forwardCalls,
+            AllocCounters::GetThreadCounts() - allocCounts};
+}
+
+// Adds the counters of the results to the counters of the simulator and of this process, and returns their fitness
+// values.
+std::vector<double> CountEvaluationResults(const std::vector<EvaluationResult> & results,
+                                           const SnakeSimulator & simulator)
+{
+    std::vector<double>  fitnesses;
+    for (const auto & result : results)
+    {
+        SnakeGameStats  stats;
+        stats.games = result.games;
+        stats.gameSteps = result.steps;
+        stats.forwardCalls = result.forwardCalls;
+        simulator.CountGames(stats);
+        AllocCounters::AddCounts(result.allocCounts);
+        fitnesses.emplace_back(result.fitness);
+    }
+    return fitnesses;
+}
+
+}
+
 void GACmd::Run(int argc, const char *argv[])
 {
     static const char USAGE[] =
@@ -35,14 +163,31 @@ void GACmd::Run(int argc, const char *argv[])
 
     Usage:
         SnakeAIApp ga play  --modelfile=<name> [--bw=<number> --bh=<number>] [--bls=<number>]
+        SnakeAIApp ga export --modelfile=<name> --output=<name>
+        SnakeAIApp ga worker --connect=<address> --token=<text>
         SnakeAIApp ga train --modelfile=<name> [--bw=<number> --bh=<number>] [--bls=<number>]
                                                [--ps=<number>] [--pr=<number>] [--mp=<number>]
                                                [--tr=<number>] [--cr=<number>] [--sc=<number>]
-                                               [--maxGen=<number>]
+                                               [--maxGen=<number>] [--eval=<mode>] [--bs=<number>]
+                                               [--bg=<number>] [--lutmax=<number>] [--seed=<number>]
+                                               [--cache=<policy>] [--islands=<number>]
+                                               [--migrate-every=<number>] [--migrants=<number>]
+                                               [--topology=<name>] [--checkpoint=<name>]
+                                               [--checkpoint-every=<number>] [--resume=<name>]
+                                               [--evolution=<mode>] [--race=<number>]
+                                               [--race-min=<number>] [--workers=<number>]
+                                               [--worker-mem=<number>] [--listen=<number>] [--token=<text>]
+                                               [--remote-precision=<type>] [--metrics=<name>]
+                                               [--trace=<name>] [--perf]
 
     Options:
 
         --modelfile=<name>      Model filename.
+        --output=<name>         C++ header filename to export the model into.
+        --connect=<address>     Address of the training coordinator as host:port. The worker evaluates individuals
+                                of the coordinator with all CPUs until the training is finished.
+        --token=<text>          Shared secret of the coordinator and its remote workers. Required by --listen and
+                                --connect. Connections with a different token are rejected.
 
         --bw=<number>           Board width in block units.  [Default: 10]
         --bh=<number>           Board height in block units. [Default: 10]
@@ -55,6 +200,51 @@ void GACmd::Run(int argc, const char *argv[])
         --cr=number             Crossover (%).              [Default: 50]
         --sc=number             Model sampling count per generation. [Default: 2000]
         --maxGen=number         Maximum number of generation for training. [Default: 1000]
+        --eval=mode             Fitness evaluation mode: single, batched, lut. [Default: single]
+        --bs=number             Individuals per batch in batched evaluation mode. [Default: 32]
+        --bg=number             Games played in lockstep per individual in batched evaluation mode. [Default: 16]
+        --lutmax=number         Maximum policy lookup table size (KB) in lut evaluation mode. Models are not
+                                compiled into tables on boards that need larger tables. [Default: 1024]
+        --seed=number           Seed of the training run. Runs with the same seed and parameters are identical.
+                                A random seed is used if not given.
+        --cache=policy          Fitness cache policy: off, on, reeval. Identical individuals are evaluated only once
+                                when on. reeval evaluates transferred individuals in each generation again.
+                                [Default: on]
+        --islands=number        Number of islands. The population is split into islands that evolve independently
+                                on their own CPUs and exchange their best individuals periodically. [Default: 1]
+        --migrate-every=number  Number of generations between migrations. [Default: 10]
+        --migrants=number       Number of best individuals each island sends in a migration. [Default: 2]
+        --topology=name         Migration topology: ring, all. [Default: ring]
+        --evolution=mode        Evolution mode: generational, steady. In steady mode, children replace the worst
+                                individuals as soon as they are evaluated, without waiting for a whole generation.
+                                Steady runs are not reproducible. [Default: generational]
+        --race=number           Racing factor. Individuals play games in rounds and only the best 1/race of them are
+                                promoted to the next round, which plays race times more games. Parents and
+                                transferred individuals always play all games. 0 disables racing. [Default: 0]
+        --race-min=number       Number of games in the first racing round. [Default: 100]
+        --workers=number        Number of worker processes that evaluate individuals. A crash in a worker process
+                                does not stop the training, the individual gets the lowest fitness and the worker is
+                                restarted. 0 evaluates individuals in the training process. [Default: 0]
+        --worker-mem=number     Address space limit (MB) of each worker process on top of the address space it
+                                inherits from the master. 0 means no limit. [Default: 0]
+        --listen=number         Port to listen on for remote workers. Individuals are evaluated only by the remote
+                                workers started with 'ga worker'. Workers can join and leave at any time.
+        --remote-precision=type Precision of the genes sent to remote workers: double, float. float halves the network
+                                traffic, but fitness values are calculated with rounded genes. [Default: double]
+        --metrics=<name>        Per-generation performance metrics filename. Metrics are written as JSON lines, or as
+                                CSV if the filename ends with .csv. Games, steps and model inferences are counted only
+                                for the games played by this process.
+        --trace=<name>          Timeline filename. Breeding, evaluation, ranking, thread pool tasks, simulated models
+                                and saves of all threads are recorded in Chrome trace format, which Perfetto can open.
+        --perf                  Count hardware events (cycles, instructions, cache and branch misses) of breeding,
+                                ranking and game simulation with the perf_event_open interface of Linux. IPC and
+                                misses per simulated step are reported at the end of the training and in metrics.
+        --checkpoint=<name>     Checkpoint filename. The whole training state is saved periodically, at the end of
+                                the training and when the process receives SIGTERM.
+        --checkpoint-every=number  Number of generations between checkpoints. [Default: 10]
+        --resume=<name>         Checkpoint filename to resume the training from. Training parameters are restored
+                                from the checkpoint. Further checkpoints are saved into the same file unless
+                                --checkpoint is given.
     )";
 
     std::map <std::string, docopt::value>  args;
@@ -108,16 +298,148 @@ bool GACmd::ValidateArguments(std::map <std::string, docopt::value>& args, const
         !CheckRangeLong("--bls", 10, 100) ||
         !CheckRangeLong("--ps",  10, 1000000) ||
         !CheckRangeLong("--pr",  0, 100)  ||
-        !CheckRangeLong("--mr",  0, 100)  ||
+        !CheckRangeLong("--mp",  0, 100)  ||
         !CheckRangeLong("--tr",  0, 100)  ||
         !CheckRangeLong("--cr",  0, 100)  ||
         !CheckRangeLong("--sc",  1, 1000000)  ||
-        !CheckRangeLong("--maxGen", 1, 1000000))
+        !CheckRangeLong("--maxGen", 1, 1000000) ||
+        !CheckRangeLong("--bs",  1, 4096) ||
+        !CheckRangeLong("--bg",  1, 1024) ||
+        !CheckRangeLong("--lutmax", 0, 1048576) ||
+        !CheckRangeLong("--islands", 1, 1024) ||
+        !CheckRangeLong("--migrate-every", 1, 1000000) ||
+        !CheckRangeLong("--migrants", 0, 1000) ||
+        !CheckRangeLong("--checkpoint-every", 1, 1000000) ||
+        !CheckRangeLong("--race", 0, 16) ||
+        !CheckRangeLong("--race-min", 1, 1000000) ||
+        !CheckRangeLong("--workers", 0, 1024) ||
+        !CheckRangeLong("--worker-mem", 0, 1048576) ||
+        !CheckRangeLong("--listen", 1, 65535))
+    {
+        return false;
+    }
+
+    if (args["--bw"] && args["--bh"] && args["--sc"] &&
+        SnakeScenarioBank::GetMemorySize(args["--bw"].asLong(), args["--bh"].asLong(), args["--sc"].asLong()) >
+        SnakeScenarioBank::kMaxMemorySize)
+    {
+        std::cout << "Invalid --sc value. Games of the board size need more than "
+                  << SnakeScenarioBank::kMaxMemorySize / (1024 * 1024) << " MB." << std::endl;
+        return false;
+    }
+
+    if (args["--islands"] && args["--ps"] && args["--ps"].asLong() / args["--islands"].asLong() < 10)
+    {
+        std::cout << "Invalid --islands value. Each island must have at least 10 individuals." << std::endl;
+        return false;
+    }
+
+    if (args["--race"] && args["--race"].asLong() == 1)
+    {
+        std::cout << "Invalid --race value. It must be 0 or at least 2." << std::endl;
+        return false;
+    }
+
+    if (args["--race"] && args["--race"].asLong() > 0 && args["--eval"] && args["--eval"].asString() == "batched")
+    {
+        std::cout << "Racing is not supported in batched evaluation mode." << std::endl;
+        return false;
+    }
+
+    if (args["--race"] && args["--race"].asLong() > 0 && args["--evolution"] &&
+        args["--evolution"].asString() == "steady")
+    {
+        std::cout << "Racing is not supported in steady evolution mode." << std::endl;
+        return false;
+    }
+
+    if (args["--workers"] && args["--workers"].asLong() > 0 &&
+        ((args["--eval"] && args["--eval"].asString() == "batched") || (args["--race"] && args["--race"].asLong() > 0) ||
+         (args["--evolution"] && args["--evolution"].asString() == "steady")))
+    {
+        std::cout << "Worker processes are not supported in batched evaluation, racing and steady modes." << std::endl;
+        return false;
+    }
+
+    if (args["--listen"] &&
+        ((args["--eval"] && args["--eval"].asString() == "batched") || (args["--race"] && args["--race"].asLong() > 0) ||
+         (args["--evolution"] && args["--evolution"].asString() == "steady") ||
+         (args["--workers"] && args["--workers"].asLong() > 0)))
+    {
+        std::cout << "Remote workers are not supported in batched evaluation, racing, steady and worker process modes."
+                  << std::endl;
+        return false;
+    }
+
+    if ((args["--listen"] || args["--connect"]) &&
+        (!args["--token"] || args["--token"].asString().empty() || args["--token"].asString().size() > 256))
+    {
+        std::cout << "Invalid --token value. Remote workers need a token of 1 to 256 characters." << std::endl;
+        return false;
+    }
+
+    if (args["--remote-precision"] && args["--remote-precision"].asString() != "double" &&
+        args["--remote-precision"].asString() != "float")
+    {
+        std::cout << "Invalid --remote-precision value. It must be double or float." << std::endl;
+        return false;
+    }
+
+    if (args["--connect"])
+    {
+        auto address = args["--connect"].asString();
+        auto separator = address.rfind(':');
+        if (separator == std::string::npos || separator == 0 ||
+            address.find_first_not_of("0123456789", separator + 1) != std::string::npos ||
+            address.size() - separator - 1 > 5 || address.size() == separator + 1 ||
+            std::stol(address.substr(separator + 1)) < 1 || std::stol(address.substr(separator + 1)) > 65535)
+        {
+            std::cout << "Invalid --connect value. It must be host:port." << std::endl;
+            return false;
+        }
+    }
+
+    if (args["--evolution"] && args["--evolution"].asString() != "generational" &&
+        args["--evolution"].asString() != "steady")
+    {
+        std::cout << "Invalid --evolution value. It must be generational or steady." << std::endl;
+        return false;
+    }
+
+    if (args["--topology"] && args["--topology"].asString() != "ring" && args["--topology"].asString() != "all")
+    {
+        std::cout << "Invalid --topology value. It must be ring or all." << std::endl;
+        return false;
+    }
+
+    if (args["--cache"] && args["--cache"].asString() != "off" && args["--cache"].asString() != "on" &&
+        args["--cache"].asString() != "reeval")
+    {
+        std::cout << "Invalid --cache value. It must be off, on or reeval." << std::endl;
+        return false;
+    }
+
+    if (args["--seed"] && args["--seed"].asLong() < 0)
     {
+        std::cout << "Invalid --seed value. It must be a non-negative number." << std::endl;
         return false;
     }
 
-    if (args["play"].asBool() && !std::filesystem::exists(args["--modelfile"].asString()))
+    if (args["--eval"] && args["--eval"].asString() != "single" && args["--eval"].asString() != "batched" &&
+        args["--eval"].asString() != "lut")
+    {
+        std::cout << "Invalid --eval value. It must be single, batched or lut." << std::endl;
+        return false;
+    }
+
+    if (args["--resume"] && !std::filesystem::exists(args["--resume"].asString()))
+    {
+        std::cout << "Invalid --resume value. File does not exist!" << std::endl;
+        return false;
+    }
+
+    if ((args["play"].asBool() || args["export"].asBool()) &&
+        !std::filesystem::exists(args["--modelfile"].asString()))
     {
         std::cout << "Invalid --modelfile value. File does not exist!" << std::endl;
         return false;
@@ -129,7 +451,7 @@ bool GACmd::ValidateArguments(std::map <std::string, docopt::value>& args, const
 
 void GACmd::ExecuteCommand(std::map <std::string, docopt::value> & args)
 {
-    std::string  modelFilename = args["--modelfile"].asString();
+    std::string  modelFilename = args["--modelfile"] ? args["--modelfile"].asString() : "";
 
     // Override parameters here
     if (args["--bw"])  m_boardWidth  = args["--bw"].asLong();
@@ -142,6 +464,60 @@ void GACmd::ExecuteCommand(std::map <std::string, docopt::value> & args)
     if (args["--cr"])  m_gaCrossover      = args["--cr"].asLong();
     if (args["--sc"])  m_gaSamplingSize   = args["--sc"].asLong();
     if (args["--maxGen"]) m_maxGeneration = args["--maxGen"].asLong();
+    if (args["--bs"])  m_gaBatchSize      = args["--bs"].asLong();
+    if (args["--bg"])  m_gaBatchGames     = args["--bg"].asLong();
+    if (args["--lutmax"]) m_gaPolicyTableBudget = args["--lutmax"].asLong();
+    if (args["--islands"]) m_gaIslands = args["--islands"].asLong();
+    if (args["--migrate-every"]) m_gaMigrationInterval = args["--migrate-every"].asLong();
+    if (args["--migrants"]) m_gaMigrants = args["--migrants"].asLong();
+    if (args["--topology"] && args["--topology"].asString() == "all")
+    {
+        m_gaMigrationTopology = ga::MigrationTopology::kMigrationTopologyAllToAll;
+    }
+    if (args["--race"]) m_gaRaceEta = args["--race"].asLong();
+    if (args["--race-min"]) m_gaRaceMinGames = args["--race-min"].asLong();
+    if (args["--evolution"]) m_gaSteadyState = args["--evolution"].asString() == "steady";
+    if (args["--workers"]) m_gaWorkers = args["--workers"].asLong();
+    if (args["--worker-mem"]) m_gaWorkerMemory = args["--worker-mem"].asLong();
+    if (args["--listen"]) m_listenPort = args["--listen"].asLong();
+    if (args["--token"])  m_remoteToken = args["--token"].asString();
+    if (args["--remote-precision"] && args["--remote-precision"].asString() == "float")
+    {
+        m_remotePrecision = GenomePrecision::kGenomePrecisionFloat;
+    }
+    if (args["--checkpoint-every"]) m_checkpointInterval = args["--checkpoint-every"].asLong();
+    if (args["--resume"]) m_resumeFilename = args["--resume"].asString();
+    if (args["--resume"]) m_checkpointFilename = args["--resume"].asString();
+    if (args["--checkpoint"]) m_checkpointFilename = args["--checkpoint"].asString();
+    if (args["--metrics"]) m_metricsFilename = args["--metrics"].asString();
+    if (args["--trace"]) m_traceFilename = args["--trace"].asString();
+    if (args["--perf"]) m_perfCounters = args["--perf"].asBool();
+    if (args["--seed"])
+    {
+        m_gaSeed = args["--seed"].asLong();
+    }
+    else
+    {
+        std::random_device rndDev;
+        m_gaSeed = ((static_cast<uint64_t>(rndDev()) << 32) | rndDev()) >> 1;
+    }
+    if (args["--eval"] && args["--eval"].asString() == "batched")
+    {
+        m_gaEvalMode = FitnessEvalMode::kFitnessEvalModeBatched;
+    }
+    if (args["--eval"] && args["--eval"].asString() == "lut")
+    {
+        m_gaEvalMode = FitnessEvalMode::kFitnessEvalModePolicyTable;
+    }
+
+    if (args["--cache"] && args["--cache"].asString() == "off")
+    {
+        m_gaCachePolicy = ga::FitnessCachePolicy::kFitnessCachePolicyOff;
+    }
+    if (args["--cache"] && args["--cache"].asString() == "reeval")
+    {
+        m_gaCachePolicy = ga::FitnessCachePolicy::kFitnessCachePolicyReevaluateElites;
+    }
 
     if (args["play"].asBool())
     {
@@ -151,6 +527,14 @@ void GACmd::ExecuteCommand(std::map <std::string, docopt::value> & args)
     {
         TrainModel(modelFilename);
     }
+    else if (args["export"].asBool())
+    {
+        ExportModel(modelFilename, args["--output"].asString());
+    }
+    else if (args["worker"].asBool())
+    {
+        RunWorker(args["--connect"].asString(), args["--token"].asString());
+    }
 }
 
 
@@ -221,45 +605,198 @@ void GACmd::PlayModel(const std::string & modelFilename)
 
 void GACmd::TrainModel(const std::string & modelFilename)
 {
-    std::random_device rndDev;
-    std::mt19937 rndEngine(rndDev());
-    int rndSeed = static_cast<int>(rndDev());
+    double bestFitness = -std::numeric_limits<double>::max();
 
-    auto geneticVectorSize = CreateFFNN().SerializeAllParameters().size();
+    // Training parameters are restored first, the rest of the checkpoint is read after the algorithm is created.
+    std::ifstream  resumeFile;
+    if (!m_resumeFilename.empty())
+    {
+        resumeFile.open(m_resumeFilename, std::ios::binary);
+        if (!resumeFile.is_open() || !ReadTrainingState(resumeFile, bestFitness))
+        {
+            std::cout << "Failed to load the checkpoint: " << m_resumeFilename << std::endl;
+            return;
+        }
+    }
+
+    // Games are seeded from a stream that the genetic algorithm never uses. All individuals of all generations play
+    // the same games, so they are generated once and shared by all workers.
+    ga::RandomStream  seedRng(m_gaSeed, std::numeric_limits<uint32_t>::max(), 0);
+    uint64_t gameSeed = seedRng();
+    SnakeSimulator  simulator(m_boardWidth, m_boardHeight, m_gaSamplingSize, gameSeed);
+    if (m_gaEvalMode == FitnessEvalMode::kFitnessEvalModePolicyTable)
+    {
+        simulator.SetPolicyTableBudget(m_gaPolicyTableBudget);
+    }
+
+    auto geneticVectorSize = SnakeSimulator::GetParameterCount();
 
     // Create genetic algorithm to search best weights and biases for a neural network.
     ga::GeneticAlgorithm<double>  ga(m_gaPopulationSize, m_gaParentRatio, m_gaMutateProb, m_gaTransferRatio, m_gaCrossover,
                                      geneticVectorSize);
+    ga.SetSeed(m_gaSeed);
+    ga.SetFitnessCachePolicy(m_gaCachePolicy);
+    ga.SetIslands(m_gaIslands, m_gaMigrationInterval, m_gaMigrants, m_gaMigrationTopology);
+    ga.SetSteadyState(m_gaSteadyState);
 
     // This method will calculate fitness value for each individual.
-    ga.SetFitnessFunc([&](const std::vector<double> & chromosome) -> double
+    ga.SetFitnessFunc([&](std::span<const double> chromosome) -> double
     {
-        return SimulateSnakeGames(m_gaSamplingSize, chromosome, rndSeed);
+        return simulator.SimulateSnakeGames(chromosome);
     });
 
+    if (m_gaEvalMode == FitnessEvalMode::kFitnessEvalModeBatched)
+    {
+        // This method will calculate fitness values for a batch of individuals.
+        ga.SetBatchFitnessFunc([&](const std::vector<std::span<const double>> & chromosomes) -> std::vector<double>
+        {
+            return SimulateSnakeGamesBatched(m_gaSamplingSize, chromosomes, simulator);
+        }, m_gaBatchSize);
+    }
+
+    if (m_gaEvalMode != FitnessEvalMode::kFitnessEvalModeBatched && m_gaRaceEta <= 1)
+    {
+        // This method will split games of individuals across threads if the population is smaller than thread count.
+        ga.SetPopulationFitnessFunc([&](const std::vector<std::span<const double>> & chromosomes,
+                                        ThreadPool & threadPool) -> std::vector<double>
+        {
+            return simulator.SimulateSnakeGames(chromosomes, threadPool);
+        });
+    }
+
+    // Worker processes are forked from this process, so they must be started after the simulator is ready.
+    std::unique_ptr<WorkerProcessPool>  workerPool;
+    if (m_gaWorkers > 0)
+    {
+        workerPool = std::make_unique<WorkerProcessPool>(m_gaWorkers, m_gaPopulationSize, geneticVectorSize,
+            [&](std::span<const double> chromosome) -> EvaluationResult
+            {
+                return EvaluateWithCounters(simulator, chromosome);
+            }, m_gaWorkerMemory);
+
+        // This method will evaluate individuals in the worker processes. Their counters are added to the counters of
+        // this process.
+        ga.SetPopulationFitnessFunc([&](const std::vector<std::span<const double>> & chromosomes,
+                                        ThreadPool &) -> std::vector<double>
+        {
+            return CountEvaluationResults(workerPool->Evaluate(chromosomes), simulator);
+        });
+    }
+
+    // Remote workers create the same simulator from the job description.
+    std::unique_ptr<RemoteEvaluator>  remoteEvaluator;
+    if (m_listenPort > 0)
+    {
+        std::vector<uint8_t>  job;
+        auto WriteJobValue = [&](int64_t val)
+        {
+            job.insert(job.end(), reinterpret_cast<const uint8_t*>(&val), reinterpret_cast<const uint8_t*>(&val + 1));
+        };
+        WriteJobValue(m_boardWidth);
+        WriteJobValue(m_boardHeight);
+        WriteJobValue(static_cast<int64_t>(m_gaSamplingSize));
+        WriteJobValue(static_cast<int64_t>(gameSeed));
+        WriteJobValue(m_gaEvalMode == FitnessEvalMode::kFitnessEvalModePolicyTable ?
+                      static_cast<int64_t>(m_gaPolicyTableBudget) : 0);
+
+        remoteEvaluator = std::make_unique<RemoteEvaluator>(m_listenPort, m_remoteToken, geneticVectorSize,
+                                                            std::move(job), m_remotePrecision);
+        remoteEvaluator->SetInterruptFunc([]() { return g_terminateRequested != 0; });
+        std::cout << "Listening for remote workers on port: " << m_listenPort << std::endl;
+
+        // This method will evaluate individuals on the remote workers. Their counters are added to the counters of
+        // this process.
+        ga.SetPopulationFitnessFunc([&](const std::vector<std::span<const double>> & chromosomes,
+                                        ThreadPool &) -> std::vector<double>
+        {
+            return CountEvaluationResults(remoteEvaluator->Evaluate(chromosomes), simulator);
+        });
+    }
+
+    if (m_gaRaceEta > 1)
+    {
+        // This method will race all individuals of a generation against each other.
+        ga.SetPopulationFitnessFunc([&](const std::vector<std::span<const double>> & chromosomes,
+                                        ThreadPool & threadPool) -> std::vector<double>
+        {
+            return RaceSnakeGames(m_gaSamplingSize, chromosomes, threadPool, simulator);
+        });
+    }
+
     // This method will generate random item (genes) for a genetic vector/material (chromosome).
-    ga.SetRandomItemFunc([&]() -> double
+    ga.SetRandomItemFunc([&](ga::RandomStream & rng) -> double
     {
-        // Scale the random fraction to the desired range [min, max]
+        // Scale the random fraction to the desired range [min, max)
         constexpr double min = -1;
         constexpr double max =  1;
-        return std::uniform_real_distribution<double>(min, max)(rndEngine);
+        return rng.Uniform(min, max);
     });
 
-    ga.CreateInitialPopulation();
+    if (!m_traceFilename.empty())
+    {
+        Tracer::Start();
+    }
 
-    double bestFitness = -std::numeric_limits<double>::max();
+    bool countPerfEvents = m_perfCounters && PerfCounters::Start();
+    if (m_perfCounters && !countPerfEvents)
+    {
+        std::cout << "Hardware performance counters are not available." << std::endl;
+    }
+    auto startCounters = simulator.GetCounters();
+
+    // Stop gracefully on SIGTERM. The current generation is completed and saved into the checkpoint.
+    g_terminateRequested = 0;
+    std::signal(SIGTERM, [](int) { g_terminateRequested = 1; });
+
+    if (resumeFile.is_open())
+    {
+        if (!ga.Load(resumeFile))
+        {
+            std::cout << "Failed to load the checkpoint: " << m_resumeFilename << std::endl;
+            return;
+        }
+        resumeFile.close();
+    }
+    else
+    {
+        try
+        {
+            ga.CreateInitialPopulation();
+        }
+        catch (const RemoteEvaluationInterrupted &)
+        {
+            std::cout << "Training is terminated while waiting for remote workers." << std::endl;
+            return;
+        }
+    }
 
+    std::cout << "CPU Kernels: " << kernels::GetKernels().name << "\n";
+    std::cout << "Seed: " << m_gaSeed << "\n";
     std::cout << "Total Model Parameters: " << geneticVectorSize << "\n";
 
-    while (ga.GetGeneration() < m_maxGeneration)
+    TrainingMetricsWriter  metricsWriter;
+    if (!m_metricsFilename.empty() && !metricsWriter.Open(m_metricsFilename))
     {
+        std::cout << "Failed to create the metrics file: " << m_metricsFilename << std::endl;
+        return;
+    }
+
+    std::size_t totalEvaluations = ga.GetEvaluationCount();
+    double evaluationsPerSecond = 0;
+    std::size_t startGeneration = ga.GetGeneration();
+    auto startAllocCounts = AllocCounters::GetCounts();
+
+    bool interrupted = false;
+    while (ga.GetGeneration() < m_maxGeneration && !g_terminateRequested)
+    {
+        auto saveStartTime = std::chrono::steady_clock::now();
         double fitness = ga.GetBestIndividual().GetFitness();
 
         // Save the best individual.
         if (fitness > bestFitness)
         {
-            auto ffnn = CreateFFNN();
+            TraceScope  traceScope("SaveModel");
+            auto ffnn = SnakeSimulator::CreateFFNN();
             // Set genes vector (weights and biases) coming from genetic algorithm.
             ffnn.DeserializeAllParameters(ga.GetBestIndividual().GetValue());
             ffnn.Save(modelFilename);
@@ -267,24 +804,549 @@ void GACmd::TrainModel(const std::string & modelFilename)
             bestFitness = fitness;
         }
 
-        std::cout << "Generation: " << ga.GetGeneration() << "  Fitness: " << bestFitness << "\n";
-        ga.CreateNextPopulation();
+        // Steady-state evolution has no real generations, so its progress is reported by evaluations.
+        if (m_gaSteadyState)
+        {
+            std::cout << "Evaluations: " << totalEvaluations << "  Evals/sec: " << std::fixed << std::setprecision(1)
+                      << evaluationsPerSecond << std::defaultfloat << std::setprecision(6)
+                      << "  Fitness: " << bestFitness << "\n";
+        }
+        else
+        {
+            std::cout << "Generation: " << ga.GetGeneration() << "  Fitness: " << bestFitness << "\n";
+        }
+
+        std::chrono::duration<double>  saveElapsed = std::chrono::steady_clock::now() - saveStartTime;
+        auto counters = simulator.GetCounters();
+        double busyTime = ga.GetThreadBusyTime();
+        auto breedCounts = PerfCounters::GetCounts(PerfRegion::kPerfRegionBreed);
+        auto rankCounts = PerfCounters::GetCounts(PerfRegion::kPerfRegionRank);
+        auto simulateCounts = PerfCounters::GetCounts(PerfRegion::kPerfRegionSimulate);
+        auto allocCounts = AllocCounters::GetCounts();
+
+        auto startTime = std::chrono::steady_clock::now();
+        std::size_t failureCount = workerPool ? workerPool->GetFailureCount() : 0;
+        std::size_t redispatchCount = remoteEvaluator ? remoteEvaluator->GetRedispatchCount() : 0;
+        try
+        {
+            ga.CreateNextPopulation();
+        }
+        catch (const RemoteEvaluationInterrupted &)
+        {
+            // The generation is incomplete. The last saved checkpoint is kept.
+            std::cout << "Training is terminated while waiting for remote workers." << std::endl;
+            interrupted = true;
+            break;
+        }
+        if (workerPool && workerPool->GetFailureCount() > failureCount)
+        {
+            std::cout << "Worker processes crashed and restarted: " << workerPool->GetFailureCount() - failureCount
+                      << "\n";
+        }
+        if (remoteEvaluator && remoteEvaluator->GetRedispatchCount() > redispatchCount)
+        {
+            std::cout << "Batches of lost remote workers sent again: "
+                      << remoteEvaluator->GetRedispatchCount() - redispatchCount << "  Remote workers: "
+                      << remoteEvaluator->GetWorkerCount() << "\n";
+        }
+        std::chrono::duration<double>  elapsed = std::chrono::steady_clock::now() - startTime;
+
+        totalEvaluations += ga.GetEvaluationCount();
+        evaluationsPerSecond = elapsed.count() > 0 ? double(ga.GetEvaluationCount()) / elapsed.count() : 0;
+
+        if (!m_checkpointFilename.empty() &&
+            (ga.GetGeneration() % m_checkpointInterval == 0 || ga.GetGeneration() >= m_maxGeneration ||
+             g_terminateRequested))
+        {
+            if (!SaveCheckpoint(m_checkpointFilename, ga, bestFitness))
+            {
+                std::cout << "Failed to save the checkpoint: " << m_checkpointFilename << std::endl;
+            }
+        }
+
+        if (!m_metricsFilename.empty())
+        {
+            // Save time covers the model saved before and the checkpoint saved after the generation.
+            saveElapsed += std::chrono::steady_clock::now() - startTime - elapsed;
+
+            auto times = ga.GetGenerationTimes();
+            auto newCounters = simulator.GetCounters();
+            auto fitnessValues = ga.GetFitnessValues();
+            std::sort(fitnessValues.begin(), fitnessValues.end(), std::greater<>());
+
+            GenerationMetrics  metrics;
+            metrics.generation    = ga.GetGeneration();
+            metrics.wallTime      = elapsed.count() + saveElapsed.count();
+            metrics.breedTime     = times.breed;
+            metrics.evaluateTime  = times.evaluate;
+            metrics.rankTime      = times.rank;
+            metrics.saveTime      = saveElapsed.count();
+            metrics.evaluations   = ga.GetEvaluationCount();
+            metrics.games         = newCounters.games - counters.games;
+            metrics.steps         = newCounters.steps - counters.steps;
+            metrics.forwardCalls  = newCounters.forwardCalls - counters.forwardCalls;
+            metrics.threadUtilization = elapsed.count() > 0 ? (ga.GetThreadBusyTime() - busyTime) /
+                                                              (elapsed.count() * double(ga.GetThreadCount())) : 0;
+            metrics.maxFitness    = fitnessValues.front();
+            metrics.minFitness    = fitnessValues.back();
+            metrics.medianFitness = (fitnessValues[(fitnessValues.size() - 1) / 2] +
+                                     fitnessValues[fitnessValues.size() / 2]) / 2;
+
+            std::size_t eliteCount = m_gaTransferRatio * m_gaPopulationSize / 100;
+            if (eliteCount > 0)
+            {
+                metrics.eliteCutoff = fitnessValues[eliteCount - 1];
+            }
+
+            if (AllocCounters::IsAvailable())
+            {
+                auto allocDelta = AllocCounters::GetCounts() - allocCounts;
+                metrics.allocations    = double(allocDelta.allocations);
+                metrics.allocatedBytes = double(allocDelta.bytes);
+            }
+
+            if (countPerfEvents)
+            {
+                auto Delta = [](const PerfCounts & before, const PerfCounts & after)
+                {
+                    PerfCounts  delta;
+                    for (std::size_t e=0; e<delta.values.size(); ++e)
+                    {
+                        delta.values[e] = after.values[e] - before.values[e];
+                    }
+                    return delta;
+                };
+
+                auto simulateDelta = Delta(simulateCounts, PerfCounters::GetCounts(PerfRegion::kPerfRegionSimulate));
+                metrics.breedIPC    = Delta(breedCounts, PerfCounters::GetCounts(PerfRegion::kPerfRegionBreed)).GetIPC();
+                metrics.rankIPC     = Delta(rankCounts, PerfCounters::GetCounts(PerfRegion::kPerfRegionRank)).GetIPC();
+                metrics.simulateIPC = simulateDelta.GetIPC();
+                if (metrics.steps > 0)
+                {
+                    auto PerStep = [&](PerfEvent event)
+                    {
+                        return PerfCounters::IsAvailable(event) ? double(simulateDelta[event]) / double(metrics.steps)
+                                                                : std::numeric_limits<double>::quiet_NaN();
+                    };
+                    metrics.cyclesPerStep       = PerStep(PerfEvent::kPerfEventCycles);
+                    metrics.l1dMissesPerStep    = PerStep(PerfEvent::kPerfEventL1DMisses);
+                    metrics.llcMissesPerStep    = PerStep(PerfEvent::kPerfEventLLCMisses);
+                    metrics.branchMissesPerStep = PerStep(PerfEvent::kPerfEventBranchMisses);
+                }
+            }
+
+            metricsWriter.Write(metrics);
+        }
+    }
+
+    if (AllocCounters::IsAvailable())
+    {
+        PrintAllocCounts(AllocCounters::GetCounts() - startAllocCounts, ga.GetGeneration() - startGeneration,
+                         simulator.GetCounters().steps - startCounters.steps);
+    }
+
+    if (countPerfEvents)
+    {
+        PerfCounters::Stop();
+        PrintPerfCounters(simulator.GetCounters().steps - startCounters.steps);
+    }
+
+    if (!m_traceFilename.empty())
+    {
+        Tracer::Stop();
+        if (!Tracer::Save(m_traceFilename))
+        {
+            std::cout << "Failed to save the trace: " << m_traceFilename << std::endl;
+        }
+    }
+
+    if (g_terminateRequested && !interrupted)
+    {
+        std::cout << "Training is terminated at generation " << ga.GetGeneration() << "." << std::endl;
     }
 }
 
 
-FFNN GACmd::CreateFFNN()
+void GACmd::PrintPerfCounters(uint64_t simulatedSteps) const
 {
-    // First determine genetic vector size.
-    int modelInputSize = static_cast<int>(SnakeGame::GetParameterSize());
+    // Writes the event count, or n/a if the CPU doesn't support the event.
+    auto PrintEvent = [](const char * name, PerfEvent event, double value)
+    {
+        std::cout << "  " << name << ": ";
+        if (PerfCounters::IsAvailable(event))
+        {
+            std::cout << value;
+        }
+        else
+        {
+            std::cout << "n/a";
+        }
+    };
 
-    std::vector<int>  ffnnLayers{modelInputSize, modelInputSize, modelInputSize/2, 4};
+    std::cout << "Hardware performance counters (user space, all threads):\n";
 
-    std::vector<ActivationType> activations{ActivationType::kActivationTypeTanh,
-                                            ActivationType::kActivationTypeTanh,
-                                            ActivationType::kActivationTypeSigmoid};
+    const std::pair<const char *, PerfRegion>  regions[] = {{"Breed   ", PerfRegion::kPerfRegionBreed},
+                                                            {"Rank    ", PerfRegion::kPerfRegionRank},
+                                                            {"Simulate", PerfRegion::kPerfRegionSimulate}};
+    for (const auto & [name, region] : regions)
+    {
+        auto counts = PerfCounters::GetCounts(region);
+        std::cout << name;
+        PrintEvent("Cycles", PerfEvent::kPerfEventCycles, double(counts[PerfEvent::kPerfEventCycles]));
+        PrintEvent("Instructions", PerfEvent::kPerfEventInstructions, double(counts[PerfEvent::kPerfEventInstructions]));
+        PrintEvent("IPC", PerfEvent::kPerfEventInstructions, counts.GetIPC());
+        PrintEvent("L1D misses", PerfEvent::kPerfEventL1DMisses, double(counts[PerfEvent::kPerfEventL1DMisses]));
+        PrintEvent("LLC misses", PerfEvent::kPerfEventLLCMisses, double(counts[PerfEvent::kPerfEventLLCMisses]));
+        PrintEvent("Branch misses", PerfEvent::kPerfEventBranchMisses, double(counts[PerfEvent::kPerfEventBranchMisses]));
+        std::cout << "\n";
+    }
 
-    return FFNN(ffnnLayers, activations);
+    if (simulatedSteps > 0)
+    {
+        auto counts = PerfCounters::GetCounts(PerfRegion::kPerfRegionSimulate);
+        double steps = double(simulatedSteps);
+        std::cout << "Per step";
+        PrintEvent("Cycles", PerfEvent::kPerfEventCycles, double(counts[PerfEvent::kPerfEventCycles]) / steps);
+        PrintEvent("Instructions", PerfEvent::kPerfEventInstructions,
+                   double(counts[PerfEvent::kPerfEventInstructions]) / steps);
+        PrintEvent("L1D misses", PerfEvent::kPerfEventL1DMisses, double(counts[PerfEvent::kPerfEventL1DMisses]) / steps);
+        PrintEvent("LLC misses", PerfEvent::kPerfEventLLCMisses, double(counts[PerfEvent::kPerfEventLLCMisses]) / steps);
+        PrintEvent("Branch misses", PerfEvent::kPerfEventBranchMisses,
+                   double(counts[PerfEvent::kPerfEventBranchMisses]) / steps);
+        std::cout << "\n";
+    }
+    std::cout << std::flush;
+}
+
+
+void GACmd::PrintAllocCounts(const AllocCounts & counts, std::size_t generations, uint64_t simulatedSteps) const
+{
+    std::cout << "Heap allocations (all threads):  Allocations: " << counts.allocations
+              << "  Deallocations: " << counts.deallocations << "  Bytes: " << counts.bytes;
+    if (generations > 0)
+    {
+        std::cout << "  Per generation: " << double(counts.allocations) / double(generations);
+    }
+    if (simulatedSteps > 0)
+    {
+        std::cout << "  Per step: " << double(counts.allocations) / double(simulatedSteps);
+    }
+    std::cout << std::endl;
+}
+
+
+void GACmd::RunWorker(const std::string & address, const std::string & token)
+{
+    auto separator = address.rfind(':');
+    RemoteWorker  worker(address.substr(0, separator), std::stoi(address.substr(separator + 1)), token);
+    std::unique_ptr<SnakeSimulator>  simulator;
+
+    std::cout << "Connecting to coordinator: " << address << std::endl;
+
+    bool success = worker.Run([&](std::size_t genomeLength, std::span<const uint8_t> job) -> RemoteFitnessFunc
+    {
+        // Models of the coordinator must have the same topology.
+        if (genomeLength != SnakeSimulator::GetParameterCount())
+        {
+            std::cout << "Model of the coordinator has " << genomeLength << " parameters, expected "
+                      << SnakeSimulator::GetParameterCount() << "." << std::endl;
+            return {};
+        }
+
+        // Reads an int64 value from the job description.
+        auto ReadJobValue = [&]() -> int64_t
+        {
+            int64_t val = 0;
+            if (job.size() >= sizeof(val))
+            {
+                std::memcpy(&val, job.data(), sizeof(val));
+                job = job.subspan(sizeof(val));
+            }
+            return val;
+        };
+
+        auto boardWidth    = ReadJobValue();
+        auto boardHeight   = ReadJobValue();
+        auto samplingSize  = ReadJobValue();
+        auto gameSeed      = ReadJobValue();
+        auto policyTableBudget = ReadJobValue();
+        if (boardWidth < 10 || boardWidth > 100 || boardHeight < 10 || boardHeight > 100 || samplingSize < 1 ||
+            samplingSize > 1000000 || policyTableBudget < 0)
+        {
+            std::cout << "Invalid job received from the coordinator." << std::endl;
+            return {};
+        }
+
+        simulator = std::make_unique<SnakeSimulator>(boardWidth, boardHeight, samplingSize, gameSeed);
+        simulator->SetPolicyTableBudget(policyTableBudget);
+        std::cout << "Board: " << boardWidth << "x" << boardHeight << "  Games: " << samplingSize << std::endl;
+
+        return [&](std::span<const double> chromosome) -> EvaluationResult
+        {
+            return EvaluateWithCounters(*simulator, chromosome);
+        };
+    });
+
+    std::cout << (success ? "Training is finished." : "Lost connection to the coordinator.") << std::endl;
+}
+
+
+bool GACmd::SaveCheckpoint(const std::string & filename, const ga::GeneticAlgorithm<double> & ga,
+                           double bestFitness) const
+{
+    TraceScope  traceScope("SaveCheckpoint");
+
+    // The checkpoint is serialized in memory first, so the file is written with a single durable write.
+    std::ostringstream  stream(std::ios::binary);
+    WriteTrainingState(stream, bestFitness);
+    ga.Save(stream);
+    if (!stream)
+    {
+        return false;
+    }
+
+    return WriteFileAtomically(filename, stream.str());
+}
+
+
+void GACmd::WriteTrainingState(std::ostream & stream, double bestFitness) const
+{
+    // Writes an int64 value to the stream.
+    auto WriteInt64 = [&](int64_t val) { stream.write(reinterpret_cast<const char*>(&val), sizeof(val)); };
+
+    stream.write(kCheckpointMagic, sizeof(kCheckpointMagic));
+    WriteInt64(m_boardWidth);
+    WriteInt64(m_boardHeight);
+    WriteInt64(static_cast<int64_t>(m_gaPopulationSize));
+    WriteInt64(static_cast<int64_t>(m_gaParentRatio));
+    WriteInt64(static_cast<int64_t>(m_gaMutateProb));
+    WriteInt64(static_cast<int64_t>(m_gaTransferRatio));
+    WriteInt64(static_cast<int64_t>(m_gaCrossover));
+    WriteInt64(static_cast<int64_t>(m_gaSamplingSize));
+    WriteInt64(static_cast<int64_t>(m_gaEvalMode));
+    WriteInt64(static_cast<int64_t>(m_gaBatchSize));
+    WriteInt64(static_cast<int64_t>(m_gaBatchGames));
+    WriteInt64(static_cast<int64_t>(m_gaPolicyTableBudget));
+    WriteInt64(static_cast<int64_t>(m_gaCachePolicy));
+    WriteInt64(static_cast<int64_t>(m_gaIslands));
+    WriteInt64(static_cast<int64_t>(m_gaMigrationInterval));
+    WriteInt64(static_cast<int64_t>(m_gaMigrants));
+    WriteInt64(static_cast<int64_t>(m_gaMigrationTopology));
+    WriteInt64(static_cast<int64_t>(m_gaSeed));
+    WriteInt64(m_gaSteadyState ? 1 : 0);
+    WriteInt64(static_cast<int64_t>(m_gaRaceEta));
+    WriteInt64(static_cast<int64_t>(m_gaRaceMinGames));
+    stream.write(reinterpret_cast<const char*>(&bestFitness), sizeof(bestFitness));
+}
+
+
+bool GACmd::ReadTrainingState(std::istream & stream, double & bestFitness)
+{
+    // Reads an int64 value from the stream.
+    auto ReadInt64 = [&]() { int64_t val{0}; stream.read(reinterpret_cast<char*>(&val), sizeof(val)); return val; };
+
+    char magic[sizeof(kCheckpointMagic)]{};
+    stream.read(magic, sizeof(magic));
+    if (!std::equal(std::begin(magic), std::end(magic) - 1, std::begin(kCheckpointMagic)))
+    {
+        return false;
+    }
+    if (magic[sizeof(magic) - 1] != kCheckpointMagic[sizeof(kCheckpointMagic) - 1])
+    {
+        std::cout << "Checkpoint format version " << magic[sizeof(magic) - 1] << " is not supported. Expected version "
+                  << kCheckpointMagic[sizeof(kCheckpointMagic) - 1] << "." << std::endl;
+        return false;
+    }
+
+    m_boardWidth          = static_cast<int>(ReadInt64());
+    m_boardHeight         = static_cast<int>(ReadInt64());
+    m_gaPopulationSize    = ReadInt64();
+    m_gaParentRatio       = ReadInt64();
+    m_gaMutateProb        = ReadInt64();
+    m_gaTransferRatio     = ReadInt64();
+    m_gaCrossover         = ReadInt64();
+    m_gaSamplingSize      = ReadInt64();
+    m_gaEvalMode          = static_cast<FitnessEvalMode>(ReadInt64());
+    m_gaBatchSize         = ReadInt64();
+    m_gaBatchGames        = ReadInt64();
+    m_gaPolicyTableBudget = ReadInt64();
+    m_gaCachePolicy       = static_cast<ga::FitnessCachePolicy>(ReadInt64());
+    m_gaIslands           = ReadInt64();
+    m_gaMigrationInterval = ReadInt64();
+    m_gaMigrants          = ReadInt64();
+    m_gaMigrationTopology = static_cast<ga::MigrationTopology>(ReadInt64());
+    m_gaSeed              = static_cast<uint64_t>(ReadInt64());
+    m_gaSteadyState       = ReadInt64() != 0;
+    m_gaRaceEta           = ReadInt64();
+    m_gaRaceMinGames      = ReadInt64();
+    stream.read(reinterpret_cast<char*>(&bestFitness), sizeof(bestFitness));
+
+    return static_cast<bool>(stream);
+}
+
+
+void GACmd::ExportModel(const std::string & modelFilename, const std::string & outputFilename)
+{
+    FFNN  ffnn;
+    if (!ffnn.Load(modelFilename))
+    {
+        std::cout << "Failed to load the model: " << modelFilename << std::endl;
+        return;
+    }
+
+    auto layers      = ffnn.GetLayers();
+    auto activations = ffnn.GetActivationTypes();
+    const auto & weights = ffnn.GetWeights();
+    const auto & biases  = ffnn.GetBiases();
+
+    if (layers.front() != static_cast<int>(SnakeGame::GetParameterSize()) || layers.back() != 4)
+    {
+        std::cout << "Model topology is not compatible with the snake game policy." << std::endl;
+        return;
+    }
+
+    std::ofstream  file(outputFilename);
+    if (!file.is_open())
+    {
+        std::cout << "Failed to create the output file: " << outputFilename << std::endl;
+        return;
+    }
+
+    // max_digits10 guarantees that the parameters are reproduced bit-exactly by the compiler.
+    file << std::setprecision(std::numeric_limits<double>::max_digits10);
+
+    // Returns the C++ expression of an activation function for the given argument.
+    auto ActivationExpr = [](ActivationType type, const std::string & x) -> std::string
+    {
+        switch (type)
+        {
+            case ActivationType::kActivationTypeSigmoid:    return "Sigmoid(" + x + ")";
+            case ActivationType::kActivationTypeTanh:       return "Tanh(" + x + ")";
+            case ActivationType::kActivationTypeReLU:       return "ReLU(" + x + ")";
+            case ActivationType::kActivationTypeLeakyReLU:  return "LeakyReLU(" + x + ")";
+            case ActivationType::kActivationTypeSoftmax:    return "std::exp(" + x + ")";
+            default:
+                throw std::runtime_error("Unknown activation type encountered when exporting the model.");
+        }
+    };
+
+    file << "//\n"
+         << "//  Snake AI policy generated by SnakeAIApp from " << std::filesystem::path(modelFilename).filename()
+         << ". Do not edit.\n"
+         << "//\n"
+         << "//  Topology:";
+    for (std::size_t i=0; i<layers.size(); ++i)
+    {
+        file << (i == 0 ? " " : " -> ") << layers[i];
+    }
+    file << "\n//\n\n"
+         << "#pragma once\n\n"
+         << "// System includes\n"
+         << "#include <array>\n"
+         << "#include <cmath>\n"
+         << "#include <cstdint>\n\n\n"
+         << "namespace sai::policy\n{\n\n"
+         << "enum class SnakeDirection : int32_t\n{\n"
+         << "    kSnakeDirUp     = 0,\n"
+         << "    kSnakeDirDown   = 1,\n"
+         << "    kSnakeDirLeft   = 2,\n"
+         << "    kSnakeDirRight  = 3,\n"
+         << "};\n\n";
+
+    // Weights are stored as [output][input] so that each row holds the incoming weights of a single neuron.
+    for (std::size_t l=0; l<weights.size(); ++l)
+    {
+        file << "constexpr double kLayer" << l << "Weights[" << weights[l].cols() << "][" << weights[l].rows()
+             << "] =\n{\n";
+        for (Eigen::Index o=0; o<weights[l].cols(); ++o)
+        {
+            file << "    {";
+            for (Eigen::Index i=0; i<weights[l].rows(); ++i)
+            {
+                file << (i == 0 ? " " : ", ") << weights[l](i, o);
+            }
+            file << " },\n";
+        }
+        file << "};\n\n";
+
+        file << "constexpr double kLayer" << l << "Biases[" << biases[l].cols() << "] =\n{\n   ";
+        for (Eigen::Index o=0; o<biases[l].cols(); ++o)
+        {
+            file << " " << biases[l](0, o) << ",";
+        }
+        file << "\n};\n\n";
+    }
+
+    // Activation functions. They match the FFNN implementations.
+    file << "inline double Sigmoid(double x)   { return 1.0 / (1.0 + std::exp(-x)); }\n"
+         << "inline double Tanh(double x)      { return (std::exp(x) - std::exp(-x)) / (std::exp(x) + std::exp(-x)); }\n"
+         << "inline double ReLU(double x)      { return x > 0 ? x : 0; }\n"
+         << "inline double LeakyReLU(double x) { return x > 0 ? x : x * 0.001; }\n\n";
+
+    // Straight-line forward pass. Every neuron is a single expression of constexpr parameters.
+    file << "// Returns model outputs for the given game parameters.\n"
+         << "inline std::array<double, " << layers.back() << "> Forward(const std::array<double, " << layers.front()
+         << "> & in)\n{\n";
+
+    std::string  inputName = "in";
+    for (std::size_t l=0; l<weights.size(); ++l)
+    {
+        bool isSoftmax = activations[l] == ActivationType::kActivationTypeSoftmax;
+        std::string  outputName = "h" + std::to_string(l);
+
+        for (Eigen::Index o=0; o<weights[l].cols(); ++o)
+        {
+            std::string  sum = "kLayer" + std::to_string(l) + "Biases[" + std::to_string(o) + "]";
+            for (Eigen::Index i=0; i<weights[l].rows(); ++i)
+            {
+                sum += " + " + inputName + "[" + std::to_string(i) + "] * kLayer" + std::to_string(l) + "Weights[" +
+                       std::to_string(o) + "][" + std::to_string(i) + "]";
+            }
+            file << "    const double " << outputName << "_" << o << " = " << ActivationExpr(activations[l], sum)
+                 << ";\n";
+        }
+
+        // Softmax normalizes exponentials of the layer by their sum.
+        if (isSoftmax)
+        {
+            file << "    const double " << outputName << "_sum =";
+            for (Eigen::Index o=0; o<weights[l].cols(); ++o)
+            {
+                file << (o == 0 ? " " : " + ") << outputName << "_" << o;
+            }
+            file << ";\n";
+        }
+
+        file << "    const double " << outputName << "[" << weights[l].cols() << "] = {";
+        for (Eigen::Index o=0; o<weights[l].cols(); ++o)
+        {
+            file << (o == 0 ? " " : ", ") << outputName << "_" << o << (isSoftmax ? " / " + outputName + "_sum" : "");
+        }
+        file << " };\n\n";
+
+        inputName = outputName;
+    }
+
+    file << "    return {";
+    for (int o=0; o<layers.back(); ++o)
+    {
+        file << (o == 0 ? " " : ", ") << inputName << "[" << o << "]";
+    }
+    file << " };\n}\n\n";
+
+    // Direction selection matches SnakeSimulator::DetermineSnakeDirection().
+    file << "// Returns the snake direction for the given game parameters.\n"
+         << "inline SnakeDirection Policy(const std::array<double, " << layers.front() << "> & in)\n{\n"
+         << "    const auto out = Forward(in);\n\n"
+         << "    SnakeDirection newDir = SnakeDirection::kSnakeDirUp;\n"
+         << "    double maxValue = out[0];\n\n"
+         << "    if (maxValue < out[1]) { newDir = SnakeDirection::kSnakeDirDown; maxValue = out[1]; }\n"
+         << "    if (maxValue < out[2]) { newDir = SnakeDirection::kSnakeDirLeft; maxValue = out[2]; }\n"
+         << "    if (maxValue < out[3]) { newDir = SnakeDirection::kSnakeDirRight; }\n\n"
+         << "    return newDir;\n}\n\n"
+         << "} // namespace sai::policy\n";
+
+    std::cout << "Model is exported to " << outputFilename << std::endl;
 }
 
 
@@ -298,7 +1360,7 @@ void GACmd::CalculateGameNextStep(SnakeGame& snakeGame, FFNN& ffnn) const
     auto outputs = ffnn.Forward(inputs);
 
     // Determine the best direction from model outputs. The highest value should be the new direction.
-    snakeGame.SetDirection(DetermineSnakeDirection(outputs));
+    snakeGame.SetDirection(SnakeSimulator::DetermineSnakeDirection(outputs));
 
     // Update game.
     snakeGame.Update();
@@ -352,81 +1414,202 @@ void GACmd::DrawGameBoard(sf::Text& text)
 }
 
 
-double GACmd::SimulateSnakeGames(std::size_t samplingSize, const std::vector<double> & genesVector, int rndSeed)
+std::vector<double> GACmd::RaceSnakeGames(std::size_t samplingSize,
+                                          const std::vector<std::span<const double>> & genesVectors,
+                                          ThreadPool & threadPool, const SnakeSimulator & simulator)
 {
-    // Setup a neural network.
-    auto ffnn = CreateFFNN();
-
-    // Set weights and biases coming from genetic algorithm.
-    ffnn.DeserializeAllParameters(genesVector);   // value = genetic material vector = chromosome
+    // Each contestant keeps playing its own game sequence from round to round.
+    struct Contestant
+    {
+        explicit Contestant(const SnakeScenarioBank & scenarioBank) : snakeGame(scenarioBank)
+        {
+        }
 
-    // Create a new snake game.
-    SnakeGame snakeGame(m_boardWidth, m_boardHeight, rndSeed);
+        FFNN                  ffnn;
+        SnakeGame             snakeGame;
+        std::vector<uint8_t>  policyTable;
+        SnakeGameStats        stats;
+    };
 
-    double highestScore = 0;
-    double avgDeaths = 0;
-    double avgSteps = 0;
-    double avgLongLoopFails = 0;
-    double avgScore = 0;
+    auto ffnn = SnakeSimulator::CreateFFNN();
+    auto layers = ffnn.GetLayers();
+    auto activations = ffnn.GetActivationTypes();
 
-    // Run the same model N times to assess quality of the individual (chromosome/array of genes/NN Model weights).
-    for (std::size_t i=0; i<samplingSize; ++i)
+    std::vector<std::unique_ptr<Contestant>>  contestants;
+    for (const auto & genesVector : genesVectors)
     {
-        while (snakeGame.GetGameState() == SnakeGameState::kSnakeGameStateRunning)
-        {
-            // Get game parameters to use as inputs to neural network model.
-            auto modelInputs = snakeGame.GetParameters();
-            auto inputs = Eigen::Map<Eigen::RowVectorXd>(modelInputs.data(), modelInputs.size());
+        auto contestant = std::make_unique<Contestant>(simulator.GetScenarioBank());
+        contestant->ffnn.Init(layers, activations);
+        contestant->ffnn.DeserializeAllParameters(genesVector);
+        contestant->policyTable = simulator.CreatePolicyTable(contestant->snakeGame);
+        contestants.emplace_back(std::move(contestant));
+    }
 
-            // Make prediction and get new snake directions as model outputs.
-            auto outputs = ffnn.Forward(inputs);
+    // The best individuals that become parents or are transferred must always play all games. Each island races its
+    // own individuals, so the count is relative to the raced individuals, not to the whole population.
+    std::size_t keepCount = std::max<std::size_t>(std::max(m_gaCrossover, m_gaTransferRatio) * genesVectors.size() / 100,
+                                                  1);
 
-            // Determine the best direction from model outputs. The highest value should be the new direction.
-            snakeGame.SetDirection(DetermineSnakeDirection(outputs));
+    std::vector<std::size_t>  survivors(contestants.size());
+    std::iota(survivors.begin(), survivors.end(), 0);
 
-            // Update game.
-            snakeGame.Update();
-        }
+    std::size_t gamesPlayed = 0;
+    std::size_t roundGames = std::min(m_gaRaceMinGames, samplingSize);
 
-        if (snakeGame.GetGameState() == SnakeGameState::kSnakeGameStateFailedHitWall ||
-            snakeGame.GetGameState() == SnakeGameState::kSnakeGameStateFailedHitItself)
+    while (!survivors.empty())
+    {
+        // Survivors play the games of this round in parallel.
+        std::vector<std::future<void>>  results;
+        for (auto c : survivors)
         {
-            avgDeaths++;
+            results.emplace_back(threadPool.Enqueue([&](std::size_t c)
+            {
+                TraceScope  traceScope("RaceSnakeGames");
+                PerfScope   perfScope(PerfRegion::kPerfRegionSimulate);
+                auto & contestant = *contestants[c];
+                simulator.PlaySnakeGames(roundGames - gamesPlayed, contestant.ffnn, contestant.snakeGame,
+                                         contestant.policyTable, contestant.stats);
+            }, c));
         }
-        if (snakeGame.GetGameState() == SnakeGameState::kSnakeGameStateFailedLongLoop)
+
+        // Wait until all tasks are finished.
+        for (auto & result : results)
         {
-            avgLongLoopFails++;
+            result.wait();
+            result.get();     // We don't have a return value but this will rethrow an uncaught exception.
         }
 
-        highestScore = std::max<double>(highestScore, snakeGame.GetScore());
-        avgSteps += snakeGame.GetSteps();
-        avgScore += snakeGame.GetScore();
+        gamesPlayed = roundGames;
+        if (gamesPlayed >= samplingSize)
+        {
+            break;
+        }
 
-        snakeGame.Reset();
+        // Only the best 1/eta of the survivors are promoted to the next round, which plays eta times more games.
+        std::sort(survivors.begin(), survivors.end(), [&](std::size_t left, std::size_t right)
+        {
+            double leftFitness  = contestants[left]->stats.GetFitness();
+            double rightFitness = contestants[right]->stats.GetFitness();
+            return leftFitness > rightFitness || (leftFitness == rightFitness && left < right);
+        });
+
+        std::size_t promoted = (survivors.size() + m_gaRaceEta - 1) / m_gaRaceEta;
+        survivors.resize(std::min(survivors.size(), std::max(promoted, keepCount)));
+        roundGames = std::min(roundGames * m_gaRaceEta, samplingSize);
     }
 
-    // Return fitness value to tell the genetic algorithm how well the neural network has played the game so far.
-    // Fitness formula is very important.
-    avgSteps /= double(samplingSize);
-    avgDeaths /= double(samplingSize);
-    avgLongLoopFails /= double(samplingSize);
-    avgScore /= double(samplingSize);
+    // Eliminated individuals get the fitness estimated from the games they have played.
+    std::vector<double>  fitnesses;
+    for (const auto & contestant : contestants)
+    {
+        fitnesses.emplace_back(contestant->stats.GetFitness());
+    }
 
-    return highestScore * 500 + avgScore * 50 - avgDeaths * 15 - avgSteps * 10 - avgLongLoopFails * 100;
+    return fitnesses;
 }
 
 
-SnakeDirection GACmd::DetermineSnakeDirection(const Eigen::MatrixXd& outputs) const
+std::vector<double> GACmd::SimulateSnakeGamesBatched(std::size_t samplingSize,
+                                                     const std::vector<std::span<const double>> & genesVectors,
+                                                     const SnakeSimulator & simulator)
 {
-    SnakeDirection newDir = SnakeDirection::kSnakeDirUp;
+    TraceScope  traceScope("SimulateSnakeGamesBatched");
+    PerfScope   perfScope(PerfRegion::kPerfRegionSimulate);
+    std::size_t networkCount = genesVectors.size();
+    if (networkCount == 0)
+    {
+        return {};
+    }
+
+    // Setup neural networks with the same topology.
+    auto ffnn = SnakeSimulator::CreateFFNN();
+    BatchedFFNN  batchedFFNN(ffnn.GetLayers(), ffnn.GetActivationTypes(), networkCount);
+
+    for (std::size_t n=0; n<networkCount; ++n)
+    {
+        // Set weights and biases coming from genetic algorithm.
+        batchedFFNN.DeserializeAllParameters(n, genesVectors[n]);
+    }
+
+    // Every individual plays its games on the same number of game slots. Slot s starts on scenario s and a slot plays
+    // the next unplayed scenario after each game, so individuals play the same games as in the single evaluation mode.
+    std::size_t slotCount = std::min(m_gaBatchGames, samplingSize);
+    std::size_t gameCount = networkCount * slotCount;
+
+    std::vector<SnakeGame>  snakeGames;
+    snakeGames.reserve(gameCount);
+    for (std::size_t n=0; n<networkCount; ++n)
+    {
+        for (std::size_t s=0; s<slotCount; ++s)
+        {
+            snakeGames.emplace_back(simulator.GetScenarioBank(), s);
+        }
+    }
+
+    std::vector<SnakeGameStats>  stats(networkCount);
+    std::vector<std::size_t>     gamesStarted(networkCount, slotCount);
+
+    // Indices of the running games. They are grouped by individual since games are created in that order.
+    std::vector<std::size_t>     activeGames(gameCount);
+    std::iota(activeGames.begin(), activeGames.end(), 0);
+
+    std::vector<Eigen::Index>    rowCounts(networkCount, static_cast<Eigen::Index>(slotCount));
+    Eigen::MatrixXd              inputs(static_cast<Eigen::Index>(gameCount),
+                                        static_cast<Eigen::Index>(SnakeGame::GetParameterSize()));
 
-    double maxValue = outputs(0, 0);
+    while (!activeGames.empty())
+    {
+        // Get game parameters of the running games to use as inputs to neural network models. Finished slots are
+        // not fed into the networks.
+        inputs.conservativeResize(static_cast<Eigen::Index>(activeGames.size()), Eigen::NoChange);
+        for (std::size_t r=0; r<activeGames.size(); ++r)
+        {
+            auto modelInputs = snakeGames[activeGames[r]].GetParameters();
+            inputs.row(static_cast<Eigen::Index>(r)) = Eigen::Map<Eigen::RowVectorXd>(modelInputs.data(),
+                                                                                     modelInputs.size());
+        }
+
+        // Make predictions of all running games at once.
+        auto outputs = batchedFFNN.Forward(inputs, rowCounts);
+
+        std::size_t stillActive = 0;
+        for (std::size_t r=0; r<activeGames.size(); ++r)
+        {
+            std::size_t g = activeGames[r];
+            std::size_t n = g / slotCount;
 
-    if (maxValue < outputs(0, 1)) { newDir = SnakeDirection::kSnakeDirDown; maxValue = outputs(0, 1); }
-    if (maxValue < outputs(0, 2)) { newDir = SnakeDirection::kSnakeDirLeft; maxValue = outputs(0, 2); }
-    if (maxValue < outputs(0, 3)) { newDir = SnakeDirection::kSnakeDirRight; }
+            auto & snakeGame = snakeGames[g];
+            snakeGame.SetDirection(SnakeSimulator::DetermineSnakeDirection(outputs, static_cast<Eigen::Index>(r)));
+            stats[n].forwardCalls++;
+            snakeGame.Update();
+
+            if (snakeGame.GetGameState() != SnakeGameState::kSnakeGameStateRunning)
+            {
+                stats[n].Add(snakeGame);
+
+                // Start a new game on the slot if the individual needs more games. Otherwise, the slot is released.
+                if (gamesStarted[n] >= samplingSize)
+                {
+                    rowCounts[n]--;
+                    continue;
+                }
+
+                snakeGame.Reset(gamesStarted[n]++);
+            }
+
+            activeGames[stillActive++] = g;
+        }
+        activeGames.resize(stillActive);
+    }
+
+    std::vector<double>  fitnesses;
+    for (const auto & stat : stats)
+    {
+        fitnesses.emplace_back(stat.GetFitness());
+        simulator.CountGames(stat);
+    }
 
-    return newDir;
+    return fitnesses;
 }
 
 
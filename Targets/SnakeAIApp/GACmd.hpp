@@ -11,18 +11,32 @@
 
 // Project includes
 #include "BaseCmd.hpp"
+#include "AllocCounters.hpp"
 #include "SFML/Graphics.hpp"
 #include "SnakeGame.hpp"
+#include "RemoteEvaluation.hpp"
+#include "SnakeSimulator.hpp"
 #include "FFNN.hpp"
+#include "GeneticAlgorithm.hpp"
 // External includes
 #include <docopt/docopt.h>
 // System includes
 #include <map>
+#include <span>
 
 
 namespace sai::cmd
 {
 
+// Fitness evaluation modes of the training.
+enum class FitnessEvalMode : int32_t
+{
+    kFitnessEvalModeSingle   = 0,     // Each individual plays its games one by one.
+    kFitnessEvalModeBatched  = 1,     // A batch of individuals plays games in lockstep with batched inference.
+    kFitnessEvalModePolicyTable = 2,  // Each individual's model is compiled into a direction table while playing.
+};
+
+
 class GACmd : public BaseCmd
 {
 public:
@@ -44,10 +58,38 @@ protected:
     void PlayModel(const std::string & modelFilename);
     void TrainModel(const std::string & modelFilename);
 
-    // Creates and returns a pre-configured FFNN object.
-    FFNN CreateFFNN();
+    // Prints hardware performance counters of the training.
+    void PrintPerfCounters(uint64_t simulatedSteps) const;
+
+    // Prints heap allocations of the training.
+    void PrintAllocCounts(const AllocCounts & counts, std::size_t generations, uint64_t simulatedSteps) const;
+
+    // Evaluates individuals of a remote training coordinator until the training is finished.
+    void RunWorker(const std::string & address, const std::string & token);
 
-    double SimulateSnakeGames(std::size_t samplingSize, const std::vector<double> & genesVector, int rndSeed);
+    // Saves the whole training state into a checkpoint file atomically.
+    bool SaveCheckpoint(const std::string & filename, const ga::GeneticAlgorithm<double> & ga, double bestFitness) const;
+
+    // Writes training parameters to a checkpoint stream.
+    void WriteTrainingState(std::ostream & stream, double bestFitness) const;
+
+    // Reads training parameters from a checkpoint stream. Returns false if the stream is not a valid checkpoint.
+    bool ReadTrainingState(std::istream & stream, double & bestFitness);
+
+    // Generates a self-contained C++ header that implements the model as a constexpr policy.
+    void ExportModel(const std::string & modelFilename, const std::string & outputFilename);
+
+    // Simulates games of many individuals together. Games of all individuals run in lockstep so that a single batched
+    // inference predicts the next steps of all of them.
+    std::vector<double> SimulateSnakeGamesBatched(std::size_t samplingSize,
+                                                  const std::vector<std::span<const double>> & genesVectors,
+                                                  const SnakeSimulator & simulator);
+
+    // Evaluates all individuals of a generation with successive halving. Individuals play games in rounds and only
+    // the best of each round continue. Eliminated individuals get the fitness of the games they have played.
+    std::vector<double> RaceSnakeGames(std::size_t samplingSize,
+                                       const std::vector<std::span<const double>> & genesVectors,
+                                       ThreadPool & threadPool, const SnakeSimulator & simulator);
 
     // Calculates game's next step.
     void CalculateGameNextStep(SnakeGame& snakeGame, FFNN& ffnn) const;
@@ -55,9 +97,6 @@ protected:
     // Draws game board.
     void DrawGameBoard(sf::Text& text);
 
-    // Determine direction of the snake from ML model outputs.
-    SnakeDirection DetermineSnakeDirection(const Eigen::MatrixXd& outputs) const;
-
     // Updates position of the drawable game board blocks.
     void UpdateGameBoardsDrawableBlocks(SnakeGame& snakeGame);
 
@@ -76,6 +115,30 @@ private:
     std::size_t m_gaCrossover{50};
     std::size_t m_gaSamplingSize{2000};
     std::size_t m_maxGeneration{1000};
+    FitnessEvalMode m_gaEvalMode{FitnessEvalMode::kFitnessEvalModeSingle};
+    std::size_t m_gaBatchSize{32};
+    std::size_t m_gaBatchGames{16};
+    std::size_t m_gaPolicyTableBudget{1024};    // In KB.
+    uint64_t    m_gaSeed{0};
+    ga::FitnessCachePolicy  m_gaCachePolicy{ga::FitnessCachePolicy::kFitnessCachePolicyOn};
+    std::size_t m_gaIslands{1};
+    std::size_t m_gaMigrationInterval{10};
+    std::size_t m_gaMigrants{2};
+    ga::MigrationTopology   m_gaMigrationTopology{ga::MigrationTopology::kMigrationTopologyRing};
+    bool        m_gaSteadyState{false};
+    std::size_t m_gaRaceEta{0};
+    std::size_t m_gaRaceMinGames{100};
+    std::size_t m_gaWorkers{0};
+    std::size_t m_gaWorkerMemory{0};     // In MB.
+    uint16_t    m_listenPort{0};
+    std::string m_remoteToken;
+    GenomePrecision  m_remotePrecision{GenomePrecision::kGenomePrecisionDouble};
+    std::string m_checkpointFilename;
+    std::string m_resumeFilename;
+    std::string m_metricsFilename;
+    std::string m_traceFilename;
+    bool        m_perfCounters{false};
+    std::size_t m_checkpointInterval{10};
 
     sf::RenderWindow   m_window;
     std::vector<sf::RectangleShape>  m_boardBlocks;
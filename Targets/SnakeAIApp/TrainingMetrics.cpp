@@ -0,0 +1,119 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+// Project includes
+#include "TrainingMetrics.hpp"
+// External includes
+// System includes
+#include <cmath>
+#include <iomanip>
+
+
+namespace sai::cmd
+{
+
+bool TrainingMetricsWriter::Open(const std::string & filename)
+{
+    m_csv = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".csv") == 0;
+    m_headerWritten = false;
+    m_file.open(filename, std::ios::trunc);
+    m_file << std::setprecision(10);
+    return m_file.is_open();
+}
+
+
+void TrainingMetricsWriter::Write(const GenerationMetrics & metrics)
+{
+    auto fields = GetFields(metrics);
+
+    if (m_csv)
+    {
+        if (!m_headerWritten)
+        {
+            for (std::size_t i=0; i<fields.size(); ++i)
+            {
+                m_file << (i > 0 ? "," : "") << fields[i].first;
+            }
+            m_file << "\n";
+            m_headerWritten = true;
+        }
+
+        // Unknown values are left empty.
+        for (std::size_t i=0; i<fields.size(); ++i)
+        {
+            m_file << (i > 0 ? "," : "");
+            if (std::isfinite(fields[i].second))
+            {
+                m_file << fields[i].second;
+            }
+        }
+        m_file << "\n";
+    }
+    else
+    {
+        m_file << "{";
+        for (std::size_t i=0; i<fields.size(); ++i)
+        {
+            m_file << (i > 0 ? "," : "") << "\"" << fields[i].first << "\":";
+            if (std::isfinite(fields[i].second))
+            {
+                m_file << fields[i].second;
+            }
+            else
+            {
+                m_file << "null";
+            }
+        }
+        m_file << "}\n";
+    }
+
+    // Metrics are flushed after each generation, so they can be followed while the training runs.
+    m_file.flush();
+}
+
+
+std::vector<std::pair<const char *, double>> TrainingMetricsWriter::GetFields(const GenerationMetrics & metrics)
+{
+    auto Ratio = [](double numerator, double denominator)
+    {
+        return denominator > 0 ? numerator / denominator : std::numeric_limits<double>::quiet_NaN();
+    };
+
+    return {
+        {"generation",          double(metrics.generation)},
+        {"wall_time",           metrics.wallTime},
+        {"breed_time",          metrics.breedTime},
+        {"evaluate_time",       metrics.evaluateTime},
+        {"rank_time",           metrics.rankTime},
+        {"save_time",           metrics.saveTime},
+        {"evaluations",         double(metrics.evaluations)},
+        {"games",               double(metrics.games)},
+        {"steps",               double(metrics.steps)},
+        {"steps_per_sec",       Ratio(double(metrics.steps), metrics.evaluateTime)},
+        {"forward_calls",       double(metrics.forwardCalls)},
+        {"avg_game_length",     Ratio(double(metrics.steps), double(metrics.games))},
+        {"thread_utilization",  metrics.threadUtilization},
+        {"fitness_min",         metrics.minFitness},
+        {"fitness_median",      metrics.medianFitness},
+        {"fitness_max",         metrics.maxFitness},
+        {"elite_cutoff",        metrics.eliteCutoff},
+        {"breed_ipc",           metrics.breedIPC},
+        {"rank_ipc",            metrics.rankIPC},
+        {"simulate_ipc",        metrics.simulateIPC},
+        {"cycles_per_step",     metrics.cyclesPerStep},
+        {"l1d_misses_per_step", metrics.l1dMissesPerStep},
+        {"llc_misses_per_step", metrics.llcMissesPerStep},
+        {"branch_misses_per_step", metrics.branchMissesPerStep},
+        {"allocations",         metrics.allocations},
+        {"allocated_bytes",     metrics.allocatedBytes},
+        {"allocations_per_step", Ratio(metrics.allocations, double(metrics.steps))},
+    };
+}
+
+}
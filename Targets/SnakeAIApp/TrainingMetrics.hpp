@@ -0,0 +1,81 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#pragma once
+
+// Project includes
+// External includes
+// System includes
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace sai::cmd
+{
+
+// Performance metrics of a training generation. Times are in seconds.
+struct GenerationMetrics
+{
+    std::size_t  generation{0};
+    double  wallTime{0};
+    double  breedTime{0};
+    double  evaluateTime{0};
+    double  rankTime{0};
+    double  saveTime{0};
+    std::size_t  evaluations{0};
+    uint64_t  games{0};
+    uint64_t  steps{0};
+    uint64_t  forwardCalls{0};
+    double  threadUtilization{0};       // Ratio of the time the threads spent running tasks.
+    double  minFitness{0};
+    double  medianFitness{0};
+    double  maxFitness{0};
+    double  eliteCutoff{std::numeric_limits<double>::quiet_NaN()};    // Lowest fitness transferred as is.
+
+    // Hardware performance counters. Not a number if they are not measured.
+    double  breedIPC{std::numeric_limits<double>::quiet_NaN()};
+    double  rankIPC{std::numeric_limits<double>::quiet_NaN()};
+    double  simulateIPC{std::numeric_limits<double>::quiet_NaN()};
+    double  cyclesPerStep{std::numeric_limits<double>::quiet_NaN()};
+    double  l1dMissesPerStep{std::numeric_limits<double>::quiet_NaN()};
+    double  llcMissesPerStep{std::numeric_limits<double>::quiet_NaN()};
+    double  branchMissesPerStep{std::numeric_limits<double>::quiet_NaN()};
+
+    // Heap allocations of all threads. Not a number if allocations are not counted.
+    double  allocations{std::numeric_limits<double>::quiet_NaN()};
+    double  allocatedBytes{std::numeric_limits<double>::quiet_NaN()};
+};
+
+
+// Writes generation metrics into a file. Each generation is a JSON object on its own line, or a CSV row if the
+// filename ends with .csv.
+class TrainingMetricsWriter
+{
+public:
+    // Opens the file. Returns false if the file can't be created.
+    bool Open(const std::string & filename);
+
+    // Writes metrics of a generation.
+    void Write(const GenerationMetrics & metrics);
+
+private:
+    // Returns names and values of all metrics, including the derived ones.
+    static std::vector<std::pair<const char *, double>> GetFields(const GenerationMetrics & metrics);
+
+private:
+    std::ofstream  m_file;
+    bool  m_csv{false};
+    bool  m_headerWritten{false};
+};
+
+}
@@ -10,6 +10,8 @@
 // Project includes
 #include "NoAICmd.hpp"
 #include "GACmd.hpp"
+#include "CMAESCmd.hpp"
+#include "ESCmd.hpp"
 // External includes
 // System includes
 #include <exception>
@@ -37,6 +39,10 @@ int main(int argc, const char* argv[])
 
         ga                    Use genetic algorithm to train or to play.
 
+        cmaes                 Use CMA-ES to train.
+
+        es                    Use evolution strategies to train.
+
     Use 'SnakeAIApp <command> -h' for more information on a specific command.
     )";
 
@@ -58,6 +64,16 @@ int main(int argc, const char* argv[])
             sai::cmd::GACmd cmd;
             cmd.Run(argc, argv);
         }
+        else if (args[0] == "cmaes")
+        {
+            sai::cmd::CMAESCmd cmd;
+            cmd.Run(argc, argv);
+        }
+        else if (args[0] == "es")
+        {
+            sai::cmd::ESCmd cmd;
+            cmd.Run(argc, argv);
+        }
         else
         {
             std::cerr << "Invalid commandline parameter usage. Please use '--help' parameter for more information." << std::endl;
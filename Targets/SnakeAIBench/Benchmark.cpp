@@ -0,0 +1,188 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+// Project includes
+#include "Benchmark.hpp"
+#include <AllocCounters.hpp>
+#include <Kernels.hpp>
+// External includes
+// System includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+
+namespace sai::bench
+{
+
+BenchmarkRunner::BenchmarkRunner(std::size_t repetitions, double minRepetitionTime, std::string filter) :
+    m_repetitions{std::max<std::size_t>(repetitions, 1)},
+    m_minRepetitionTime{minRepetitionTime},
+    m_filter{std::move(filter)}
+{
+}
+
+
+bool BenchmarkRunner::IsSelected(const std::string & name) const
+{
+    return m_filter.empty() || name.find(m_filter) != std::string::npos;
+}
+
+
+void BenchmarkRunner::Run(const std::string & name, const std::function<void(std::size_t iterations)> & func,
+                          double itemsPerIteration, const std::function<void()> & setup)
+{
+    if (!IsSelected(name))
+    {
+        return;
+    }
+
+    AllocCounts  allocCounts;   // Allocations of the last measurement.
+    auto Measure = [&](std::size_t iterations)
+    {
+        if (setup)
+        {
+            setup();
+        }
+
+        AllocScope  allocScope;
+        auto startTime = std::chrono::steady_clock::now();
+        func(iterations);
+        std::chrono::duration<double>  elapsed = std::chrono::steady_clock::now() - startTime;
+        allocCounts = allocScope.GetCounts();
+        return elapsed.count();
+    };
+
+    // Find the number of iterations that takes the minimum repetition time. The calibration also warms up caches
+    // and branch predictors.
+    std::size_t iterations = 1;
+    for (;;)
+    {
+        double time = Measure(iterations);
+        if (time >= m_minRepetitionTime)
+        {
+            break;
+        }
+        double scale = time > 0 ? m_minRepetitionTime * 1.4 / time : 10;
+        iterations = std::max(iterations * 2, static_cast<std::size_t>(double(iterations) * std::min(scale, 10.0)));
+    }
+
+    std::vector<double>  samples;
+    for (std::size_t r=0; r<m_repetitions; ++r)
+    {
+        samples.emplace_back(Measure(iterations) * 1e9 / double(iterations));
+    }
+
+    auto Median = [](std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        auto size = values.size();
+        return (values[(size - 1) / 2] + values[size / 2]) / 2;
+    };
+
+    BenchmarkResult  result;
+    result.name = name;
+    result.iterations = iterations;
+    result.repetitions = samples.size();
+    result.min = *std::min_element(samples.begin(), samples.end());
+    result.max = *std::max_element(samples.begin(), samples.end());
+    result.median = Median(samples);
+
+    for (auto sample : samples)
+    {
+        result.mean += sample / double(samples.size());
+    }
+
+    std::vector<double>  deviations;
+    double variance = 0;
+    for (auto sample : samples)
+    {
+        deviations.emplace_back(std::abs(sample - result.median));
+        variance += (sample - result.mean) * (sample - result.mean);
+    }
+    result.stddev = samples.size() > 1 ? std::sqrt(variance / double(samples.size() - 1)) : 0;
+    result.mad = Median(deviations);
+    result.itemsPerSecond = result.median > 0 ? itemsPerIteration * 1e9 / result.median : 0;
+    if (AllocCounters::IsAvailable())
+    {
+        result.allocations = double(allocCounts.allocations) / double(iterations);
+    }
+
+    std::cout << std::left << std::setw(48) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(16) << result.median << " ns" << "  +/- " << std::setw(5)
+              << (result.median > 0 ? result.mad / result.median * 100 : 0) << "%" << std::setw(16)
+              << result.min << " ns" << std::setw(12) << iterations;
+    if (result.allocations >= 0)
+    {
+        std::cout << std::setw(12) << result.allocations << " allocs";
+    }
+    std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+
+    m_results.emplace_back(std::move(result));
+}
+
+
+bool BenchmarkRunner::SaveJson(const std::string & filename) const
+{
+    std::ofstream  file(filename, std::ios::trunc);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    char date[32]{};
+    auto now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    file << std::setprecision(10);
+    file << "{\n";
+    file << "  \"context\": {\n";
+    file << "    \"date\": \"" << date << "\",\n";
+    file << "    \"cpu_kernels\": \"" << kernels::GetKernels().name << "\",\n";
+    file << "    \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    file << "    \"repetitions\": " << m_repetitions << ",\n";
+    file << "    \"min_repetition_time\": " << m_minRepetitionTime << "\n";
+    file << "  },\n";
+    file << "  \"benchmarks\": [";
+
+    for (std::size_t i=0; i<m_results.size(); ++i)
+    {
+        const auto & result = m_results[i];
+        file << (i > 0 ? "," : "") << "\n    {";
+        file << "\"name\": \"" << result.name << "\", ";
+        file << "\"iterations\": " << result.iterations << ", ";
+        file << "\"repetitions\": " << result.repetitions << ", ";
+        file << "\"time_unit\": \"ns\", ";
+        file << "\"min\": " << result.min << ", ";
+        file << "\"median\": " << result.median << ", ";
+        file << "\"mean\": " << result.mean << ", ";
+        file << "\"stddev\": " << result.stddev << ", ";
+        file << "\"mad\": " << result.mad << ", ";
+        file << "\"max\": " << result.max;
+        if (result.itemsPerSecond > 0)
+        {
+            file << ", \"items_per_second\": " << result.itemsPerSecond;
+        }
+        if (result.allocations >= 0)
+        {
+            file << ", \"allocations_per_iteration\": " << result.allocations;
+        }
+        file << "}";
+    }
+
+    file << "\n  ]\n}\n";
+    return file.good();
+}
+
+}
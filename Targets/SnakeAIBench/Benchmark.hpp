@@ -0,0 +1,82 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#pragma once
+
+// Project includes
+// External includes
+// System includes
+#include <functional>
+#include <string>
+#include <vector>
+
+
+namespace sai::bench
+{
+
+// Statistics of the repetitions of a benchmark. Times are in nanoseconds per operation.
+struct BenchmarkResult
+{
+    std::string  name;
+    std::size_t  iterations{0};     // Operations per repetition.
+    std::size_t  repetitions{0};
+    double  min{0};
+    double  median{0};
+    double  mean{0};
+    double  stddev{0};
+    double  mad{0};                 // Median absolute deviation from the median.
+    double  max{0};
+    double  itemsPerSecond{0};      // Processed items per second at the median time. Zero if not measured.
+    double  allocations{-1};        // Heap allocations per operation. Negative if allocations are not counted.
+};
+
+
+// Prevents the compiler from optimizing away a value computed by a benchmark.
+template<typename T>
+inline void DoNotOptimize(const T & value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+
+// Runs benchmarks and collects their results. Each benchmark is repeated many times and every repetition runs the
+// operation enough times to take at least the minimum repetition time, so that timer resolution and single outliers
+// don't affect the median.
+class BenchmarkRunner
+{
+public:
+    // Constructor. Only benchmarks whose names contain the filter are run.
+    BenchmarkRunner(std::size_t repetitions, double minRepetitionTime, std::string filter);
+
+    // Returns true if the benchmark is selected by the filter. Expensive setups can be skipped otherwise.
+    bool IsSelected(const std::string & name) const;
+
+    // Runs the benchmark if it's selected. The function runs the measured operation the given number of times. If
+    // the operation processes a known number of items, like simulated steps, their rate is reported too. The setup
+    // function, if given, runs before each repetition and is not measured.
+    void Run(const std::string & name, const std::function<void(std::size_t iterations)> & func,
+             double itemsPerIteration = 0, const std::function<void()> & setup = {});
+
+    // Returns results of all benchmarks run so far.
+    const std::vector<BenchmarkResult> & GetResults() const
+    {
+        return m_results;
+    }
+
+    // Saves the results into a JSON file. Returns false if the file can't be written.
+    bool SaveJson(const std::string & filename) const;
+
+private:
+    std::size_t  m_repetitions;
+    double  m_minRepetitionTime;    // In seconds.
+    std::string  m_filter;
+    std::vector<BenchmarkResult>  m_results;
+};
+
+}
@@ -0,0 +1,345 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+// Project includes
+#include "Benchmark.hpp"
+#include <FFNN.hpp>
+#include <GeneticAlgorithm.hpp>
+#include <SnakeGame.hpp>
+#include <SnakeSimulator.hpp>
+#include <ThreadPool.hpp>
+// External includes
+// System includes
+#include <exception>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+
+using namespace sai::bench;
+
+// Returns random model parameters in the range the trainers initialize them.
+std::vector<double> CreateRandomParameters(uint64_t seed)
+{
+    std::mt19937_64  rndEngine(seed);
+    std::uniform_real_distribution<double>  distribution(-1, 1);
+    std::vector<double>  parameters(SnakeSimulator::GetParameterCount());
+    for (auto & parameter : parameters)
+    {
+        parameter = distribution(rndEngine);
+    }
+    return parameters;
+}
+
+void BenchmarkSnakeGame(BenchmarkRunner & runner, int boardSize)
+{
+    auto board = std::to_string(boardSize) + "x" + std::to_string(boardSize);
+    SnakeScenarioBank  scenarioBank(boardSize, boardSize, 1000, 1);
+
+    runner.Run("SnakeGame/Update/" + board, [&](std::size_t iterations)
+    {
+        // The snake circles in a small square until the game fails the long loop check, then the next game starts.
+        const SnakeDirection  directions[] = {SnakeDirection::kSnakeDirRight, SnakeDirection::kSnakeDirDown,
+                                              SnakeDirection::kSnakeDirLeft, SnakeDirection::kSnakeDirUp};
+        SnakeGame  snakeGame(scenarioBank);
+        for (std::size_t i=0; i<iterations; ++i)
+        {
+            snakeGame.SetDirection(directions[(i / 2) % 4]);
+            snakeGame.Update();
+            if (snakeGame.GetGameState() != SnakeGameState::kSnakeGameStateRunning)
+            {
+                snakeGame.Reset();
+            }
+        }
+        DoNotOptimize(snakeGame.GetScore());
+    });
+
+    runner.Run("SnakeGame/Reset/" + board, [&](std::size_t iterations)
+    {
+        SnakeGame  snakeGame(scenarioBank);
+        for (std::size_t i=0; i<iterations; ++i)
+        {
+            snakeGame.Reset();
+        }
+        DoNotOptimize(snakeGame.GetScore());
+    });
+
+    runner.Run("SnakeGame/ResetWithoutBank/" + board, [&](std::size_t iterations)
+    {
+        // A game without a scenario bank places the apple by scanning the board for empty cells, which dominates
+        // the cost of its reset.
+        SnakeGame  snakeGame(boardSize, boardSize, 1);
+        for (std::size_t i=0; i<iterations; ++i)
+        {
+            snakeGame.Reset();
+        }
+        DoNotOptimize(snakeGame.GetScore());
+    });
+
+    runner.Run("SnakeGame/GetParameters/" + board, [&](std::size_t iterations)
+    {
+        SnakeGame  snakeGame(scenarioBank);
+        for (std::size_t i=0; i<iterations; ++i)
+        {
+            auto parameters = snakeGame.GetParameters();
+            DoNotOptimize(parameters.data());
+        }
+    });
+}
+
+void BenchmarkFFNN(BenchmarkRunner & runner)
+{
+    auto layers = SnakeSimulator::CreateFFNN().GetLayers();
+    auto parameters = CreateRandomParameters(1);
+
+    const std::pair<const char *, ActivationType>  activations[] = {
+        {"Sigmoid",   ActivationType::kActivationTypeSigmoid},
+        {"Tanh",      ActivationType::kActivationTypeTanh},
+        {"ReLU",      ActivationType::kActivationTypeReLU},
+        {"LeakyReLU", ActivationType::kActivationTypeLeakyReLU},
+        {"Softmax",   ActivationType::kActivationTypeSoftmax},
+    };
+
+    for (const auto & [name, activation] : activations)
+    {
+        // All layers of the model topology use the same activation.
+        FFNN  ffnn(layers, std::vector<ActivationType>(layers.size() - 1, activation));
+        ffnn.DeserializeAllParameters(parameters);
+        Eigen::MatrixXd  input = Eigen::MatrixXd::Random(1, layers.front());
+
+        runner.Run(std::string("FFNN/Forward/") + name, [&](std::size_t iterations)
+        {
+            for (std::size_t i=0; i<iterations; ++i)
+            {
+                auto output = ffnn.Forward(input);
+                DoNotOptimize(output.data());
+            }
+        });
+    }
+
+    auto ffnn = SnakeSimulator::CreateFFNN();
+
+    runner.Run("FFNN/SerializeAllParameters", [&](std::size_t iterations)
+    {
+        for (std::size_t i=0; i<iterations; ++i)
+        {
+            auto serialized = ffnn.SerializeAllParameters();
+            DoNotOptimize(serialized.data());
+        }
+    });
+
+    runner.Run("FFNN/DeserializeAllParameters", [&](std::size_t iterations)
+    {
+        bool result = true;
+        for (std::size_t i=0; i<iterations; ++i)
+        {
+            result &= ffnn.DeserializeAllParameters(parameters);
+        }
+        DoNotOptimize(result);
+    });
+}
+
+void BenchmarkSimulator(BenchmarkRunner & runner, int boardSize, std::size_t gameCount,
+                        const std::vector<double> & parameters)
+{
+    auto name = "SnakeSimulator/SimulateSnakeGames/" + std::to_string(boardSize) + "x" + std::to_string(boardSize) +
+                "/games=" + std::to_string(gameCount);
+    if (!runner.IsSelected(name))
+    {
+        return;
+    }
+
+    SnakeSimulator  simulator(boardSize, boardSize, gameCount, 1);
+
+    // The model plays the same games in each call, so all calls simulate the same number of steps.
+    simulator.SimulateSnakeGames(parameters);
+    auto steps = simulator.GetCounters().steps;
+
+    runner.Run(name, [&](std::size_t iterations)
+    {
+        for (std::size_t i=0; i<iterations; ++i)
+        {
+            DoNotOptimize(simulator.SimulateSnakeGames(parameters));
+        }
+    }, double(steps));
+}
+
+void BenchmarkGeneration(BenchmarkRunner & runner, std::size_t populationSize, int boardSize, std::size_t gameCount)
+{
+    auto name = "GeneticAlgorithm/Generation/ps=" + std::to_string(populationSize) + "/" + std::to_string(boardSize) +
+                "x" + std::to_string(boardSize) + "/games=" + std::to_string(gameCount);
+    if (!runner.IsSelected(name))
+    {
+        return;
+    }
+
+    // The algorithm is set up like the default training.
+    SnakeSimulator  simulator(boardSize, boardSize, gameCount, 1);
+    ga::GeneticAlgorithm<double>  ga(populationSize, 50, 1, 15, 50, SnakeSimulator::GetParameterCount());
+    ga.SetSeed(1);
+
+    ga.SetFitnessFunc([&](std::span<const double> chromosome) -> double
+    {
+        return simulator.SimulateSnakeGames(chromosome);
+    });
+
+    ga.SetPopulationFitnessFunc([&](const std::vector<std::span<const double>> & chromosomes,
+                                    ThreadPool & threadPool) -> std::vector<double>
+    {
+        return simulator.SimulateSnakeGames(chromosomes, threadPool);
+    });
+
+    ga.SetRandomItemFunc([&](ga::RandomStream & rng) -> double
+    {
+        return rng.Uniform(-1.0, 1.0);
+    });
+
+    ga.CreateInitialPopulation();
+
+    // Every repetition starts from the initial population, so later repetitions don't measure a more evolved one.
+    std::stringstream  initialPopulation;
+    ga.Save(initialPopulation);
+
+    runner.Run(name, [&](std::size_t iterations)
+    {
+        for (std::size_t i=0; i<iterations; ++i)
+        {
+            ga.CreateNextPopulation();
+        }
+        DoNotOptimize(ga.GetBestIndividual().GetFitness());
+    }, 0, [&]()
+    {
+        initialPopulation.clear();
+        initialPopulation.seekg(0);
+        if (!ga.Load(initialPopulation))
+        {
+            throw std::runtime_error("Can't restore the initial population.");
+        }
+    });
+}
+
+}
+
+
+int main(int argc, const char* argv[])
+{
+    static const char USAGE[] =
+    R"(
+    Snake AI Benchmark - Copyright (c) 2023-Present, Arkin Terli. All rights reserved.
+
+    Usage:
+        SnakeAIBench [--output=<name>] [--filter=<text>] [--repetitions=<number>] [--min-time=<seconds>]
+                     [--games=<number>] [--modelfile=<name>]
+
+    Options:
+        -h, --help              Show this screen.
+        --output=<name>         Results filename in JSON format. [Default: SnakeAIBench.json]
+        --filter=<text>         Runs only the benchmarks whose names contain the text.
+        --repetitions=<number>  Repetitions of each benchmark. Statistics are calculated from the repetitions.
+                                [Default: 15]
+        --min-time=<seconds>    Minimum time of a repetition. Fast operations are run many times in a repetition.
+                                [Default: 0.05]
+        --games=<number>        Games played by a model in simulation and generation benchmarks. [Default: 2000]
+        --modelfile=<name>      Model played in simulation benchmarks. A fixed random model is used if not given.
+    )";
+
+    std::string  outputFilename{"SnakeAIBench.json"};
+    std::string  filter;
+    std::size_t  repetitions{15};
+    double       minTime{0.05};
+    std::size_t  gameCount{2000};
+    std::string  modelFilename;
+
+    try
+    {
+        for (int i=1; i<argc; ++i)
+        {
+            std::string  arg{argv[i]};
+            auto separator = arg.find('=');
+            auto name  = arg.substr(0, separator);
+            auto value = separator != std::string::npos ? arg.substr(separator + 1) : std::string();
+
+            if (name == "-h" || name == "--help")
+            {
+                std::cout << USAGE << std::endl;
+                return 0;
+            }
+            else if (name == "--output")        outputFilename = value;
+            else if (name == "--filter")        filter = value;
+            else if (name == "--repetitions")   repetitions = std::stoul(value);
+            else if (name == "--min-time")      minTime = std::stod(value);
+            else if (name == "--games")         gameCount = std::stoul(value);
+            else if (name == "--modelfile")     modelFilename = value;
+            else
+            {
+                std::cerr << "Invalid commandline parameter usage. Please use '--help' parameter for more information." << std::endl;
+                return -1;
+            }
+        }
+
+        if (repetitions < 1 || gameCount < 1 || minTime < 0)
+        {
+            std::cout << "Invalid --repetitions, --games or --min-time value." << std::endl;
+            return -1;
+        }
+
+        BenchmarkRunner  runner(repetitions, minTime, filter);
+
+        for (int boardSize : {10, 20})
+        {
+            BenchmarkSnakeGame(runner, boardSize);
+        }
+
+        auto parameters = CreateRandomParameters(1);
+        if (!modelFilename.empty())
+        {
+            FFNN  ffnn;
+            if (!ffnn.Load(modelFilename))
+            {
+                std::cout << "Failed to load the model: " << modelFilename << std::endl;
+                return -1;
+            }
+            parameters = ffnn.SerializeAllParameters();
+        }
+
+        BenchmarkFFNN(runner);
+
+        for (int boardSize : {10, 20, 40})
+        {
+            BenchmarkSimulator(runner, boardSize, gameCount, parameters);
+        }
+
+        for (int boardSize : {10, 20})
+        {
+            for (std::size_t populationSize : {50, 200})
+            {
+                BenchmarkGeneration(runner, populationSize, boardSize, gameCount);
+            }
+        }
+
+        if (!runner.SaveJson(outputFilename))
+        {
+            std::cout << "Failed to save the results: " << outputFilename << std::endl;
+            return -1;
+        }
+    }
+    catch (std::exception & e)
+    {
+        std::cout << "EXCEPTION: " << e.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
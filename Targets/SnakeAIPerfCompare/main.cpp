@@ -0,0 +1,402 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+// Project includes
+// External includes
+// System includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+namespace
+{
+
+// Samples of a metric collected from the runs of a build.
+struct Metric
+{
+    bool  higherIsBetter{true};
+    bool  gated{false};             // A regression of the metric fails the comparison.
+    std::vector<double>  samples;
+};
+
+// Statistics of the samples of a metric.
+struct MetricStats
+{
+    double  mean{0};
+    double  variance{0};
+    std::size_t  count{0};
+};
+
+// Returns the two-sided 95% critical value of Student's t distribution.
+double GetCriticalT(double degreesOfFreedom)
+{
+    static const double  table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    auto index = static_cast<std::size_t>(std::max(std::floor(degreesOfFreedom), 1.0));
+    return index <= std::size(table) ? table[index - 1] : 1.96;
+}
+
+MetricStats CalculateStats(const std::vector<double> & samples)
+{
+    MetricStats  stats;
+    stats.count = samples.size();
+    for (auto sample : samples)
+    {
+        stats.mean += sample / double(samples.size());
+    }
+    for (auto sample : samples)
+    {
+        stats.variance += (sample - stats.mean) * (sample - stats.mean);
+    }
+    stats.variance = samples.size() > 1 ? stats.variance / double(samples.size() - 1) : 0;
+    return stats;
+}
+
+// Returns half width of the 95% confidence interval of the mean.
+double GetConfidence(const MetricStats & stats)
+{
+    return stats.count > 1 ? GetCriticalT(double(stats.count - 1)) * std::sqrt(stats.variance / double(stats.count))
+                           : 0;
+}
+
+// Finds a number value of a key in a single line JSON object. Returns false if the key is missing or null.
+bool FindNumber(const std::string & text, const std::string & key, double & value)
+{
+    auto pos = text.find("\"" + key + "\":");
+    if (pos == std::string::npos)
+    {
+        return false;
+    }
+
+    const char * begin = text.c_str() + pos + key.size() + 3;
+    char * end = nullptr;
+    value = std::strtod(begin, &end);
+    return end != begin;
+}
+
+// Finds a string value of a key in a single line JSON object. Returns false if the key is missing.
+bool FindString(const std::string & text, const std::string & key, std::string & value)
+{
+    auto pos = text.find("\"" + key + "\": \"");
+    if (pos == std::string::npos)
+    {
+        return false;
+    }
+
+    auto begin = pos + key.size() + 5;
+    value = text.substr(begin, text.find('"', begin) - begin);
+    return true;
+}
+
+// Adds samples of a training run. Metrics of the run are JSON lines written by 'ga train --metrics'.
+void ReadTrainingRun(const std::filesystem::path & path, const std::string & workload,
+                     std::map<std::string, Metric> & metrics)
+{
+    std::ifstream  file(path);
+    std::string  line;
+    double steps = 0;
+    double wallTime = 0;
+    std::size_t generations = 0;
+    while (std::getline(file, line))
+    {
+        double lineSteps = 0;
+        double lineWallTime = 0;
+        if (FindNumber(line, "steps", lineSteps) && FindNumber(line, "wall_time", lineWallTime))
+        {
+            steps += lineSteps;
+            wallTime += lineWallTime;
+            generations++;
+        }
+    }
+
+    if (generations == 0 || wallTime <= 0)
+    {
+        throw std::runtime_error("No generation metrics in " + path.string());
+    }
+
+    auto & stepsPerSec = metrics[workload + "/steps_per_sec"];
+    stepsPerSec.gated = true;
+    stepsPerSec.samples.emplace_back(steps / wallTime);
+
+    auto & generationTime = metrics[workload + "/generation_time"];
+    generationTime.higherIsBetter = false;
+    generationTime.samples.emplace_back(wallTime / double(generations));
+
+    // Peak memory of the run is measured by the 'run' command.
+    auto rssPath = path;
+    std::ifstream  rssFile(rssPath.replace_extension(".rss"));
+    double peakRSS = 0;
+    if (rssFile >> peakRSS)
+    {
+        auto & rss = metrics[workload + "/peak_rss_mb"];
+        rss.higherIsBetter = false;
+        rss.samples.emplace_back(peakRSS / (1024 * 1024));
+    }
+}
+
+// Adds samples of a benchmark run. Results are written by SnakeAIBench, one benchmark per line.
+void ReadBenchmarkRun(const std::filesystem::path & path, std::map<std::string, Metric> & metrics)
+{
+    std::ifstream  file(path);
+    std::string  line;
+    while (std::getline(file, line))
+    {
+        std::string  name;
+        double itemsPerSecond = 0;
+        if (FindString(line, "name", name) && FindNumber(line, "items_per_second", itemsPerSecond))
+        {
+            auto & metric = metrics[name + "/steps_per_sec"];
+            metric.gated = true;
+            metric.samples.emplace_back(itemsPerSecond);
+        }
+    }
+}
+
+// Reads all runs of a build. Training runs are named train-<workload>-<run>.jsonl and benchmark runs are named
+// bench-<run>.json.
+std::map<std::string, Metric> ReadRuns(const std::string & directory)
+{
+    std::map<std::string, Metric>  metrics;
+    for (const auto & entry : std::filesystem::directory_iterator(directory))
+    {
+        auto filename = entry.path().filename().string();
+        if (filename.starts_with("train-") && entry.path().extension() == ".jsonl")
+        {
+            auto workload = filename.substr(6, filename.rfind('-') - 6);
+            ReadTrainingRun(entry.path(), "train/" + workload, metrics);
+        }
+        else if (filename.starts_with("bench-") && entry.path().extension() == ".json")
+        {
+            ReadBenchmarkRun(entry.path(), metrics);
+        }
+    }
+    return metrics;
+}
+
+// Runs a command and writes its peak resident memory (bytes) into a file. Returns exit code of the command.
+int RunCommand(const std::string & rssFilename, std::vector<char *> & commandArgs)
+{
+    commandArgs.emplace_back(nullptr);
+
+    auto pid = fork();
+    if (pid < 0)
+    {
+        throw std::runtime_error("Can't start the command.");
+    }
+    if (pid == 0)
+    {
+        execvp(commandArgs[0], commandArgs.data());
+        _exit(127);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    rusage  usage{};
+    getrusage(RUSAGE_CHILDREN, &usage);
+#if defined(__APPLE__)
+    double peakRSS = double(usage.ru_maxrss);            // In bytes.
+#else
+    double peakRSS = double(usage.ru_maxrss) * 1024;     // In kilobytes.
+#endif
+
+    std::ofstream  file(rssFilename, std::ios::trunc);
+    file << std::setprecision(15) << peakRSS << "\n";
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Compares the runs of two builds. Returns false if a gated metric of the candidate is worse than the baseline by
+// more than the threshold (%) and the difference is significant.
+bool CompareRuns(const std::string & baselineDir, const std::string & candidateDir, double threshold,
+                 const std::string & outputFilename)
+{
+    auto baseline  = ReadRuns(baselineDir);
+    auto candidate = ReadRuns(candidateDir);
+
+    std::ofstream  output;
+    if (!outputFilename.empty())
+    {
+        output.open(outputFilename, std::ios::trunc);
+        output << std::setprecision(10) << "{\n  \"threshold\": " << threshold << ",\n  \"metrics\": [";
+    }
+
+    std::cout << std::left << std::setw(60) << "Metric" << std::right << std::setw(24) << "Baseline (95% CI)"
+              << std::setw(24) << "Candidate (95% CI)" << std::setw(24) << "Change % (95% CI)" << "\n";
+
+    bool passed = true;
+    bool firstMetric = true;
+    for (const auto & [name, baselineMetric] : baseline)
+    {
+        auto it = candidate.find(name);
+        if (it == candidate.end() || baselineMetric.samples.empty() || it->second.samples.empty())
+        {
+            continue;
+        }
+
+        auto baseStats = CalculateStats(baselineMetric.samples);
+        auto candStats = CalculateStats(it->second.samples);
+
+        // Confidence interval of the difference of the means by Welch's t-test.
+        double baseError = baseStats.count > 0 ? baseStats.variance / double(baseStats.count) : 0;
+        double candError = candStats.count > 0 ? candStats.variance / double(candStats.count) : 0;
+        double diff = candStats.mean - baseStats.mean;
+        double diffError = std::sqrt(baseError + candError);
+        double degreesOfFreedom = 1;
+        if (baseStats.count > 1 && candStats.count > 1 && diffError > 0)
+        {
+            degreesOfFreedom = (baseError + candError) * (baseError + candError) /
+                               (baseError * baseError / double(baseStats.count - 1) +
+                                candError * candError / double(candStats.count - 1));
+        }
+        double diffConfidence = GetCriticalT(degreesOfFreedom) * diffError;
+
+        double change = baseStats.mean != 0 ? diff / baseStats.mean * 100 : 0;
+        double changeConfidence = baseStats.mean != 0 ? diffConfidence / std::abs(baseStats.mean) * 100 : 0;
+
+        // Worse changes are negative for metrics where higher is better and positive otherwise.
+        double worse = baselineMetric.higherIsBetter ? -change : change;
+        bool significant = worse - changeConfidence > 0;
+        bool regression = baselineMetric.gated && worse > threshold && significant;
+        passed &= !regression;
+
+        auto FormatValue = [](double value, double confidence)
+        {
+            std::ostringstream  text;
+            text << std::fixed << std::setprecision(value >= 100 ? 0 : 3) << value << " +/- " << confidence;
+            return text.str();
+        };
+
+        std::cout << std::left << std::setw(60) << name << std::right
+                  << std::setw(24) << FormatValue(baseStats.mean, GetConfidence(baseStats))
+                  << std::setw(24) << FormatValue(candStats.mean, GetConfidence(candStats))
+                  << std::setw(24) << FormatValue(change, changeConfidence)
+                  << (regression ? "  REGRESSION" : "") << "\n";
+
+        if (output.is_open())
+        {
+            output << (firstMetric ? "" : ",") << "\n    {\"name\": \"" << name << "\", "
+                   << "\"baseline_mean\": " << baseStats.mean << ", "
+                   << "\"baseline_ci95\": " << GetConfidence(baseStats) << ", "
+                   << "\"candidate_mean\": " << candStats.mean << ", "
+                   << "\"candidate_ci95\": " << GetConfidence(candStats) << ", "
+                   << "\"change_percent\": " << change << ", "
+                   << "\"change_ci95\": " << changeConfidence << ", "
+                   << "\"gated\": " << (baselineMetric.gated ? "true" : "false") << ", "
+                   << "\"regression\": " << (regression ? "true" : "false") << "}";
+        }
+        firstMetric = false;
+    }
+
+    if (firstMetric)
+    {
+        throw std::runtime_error("No common metrics in " + baselineDir + " and " + candidateDir);
+    }
+
+    if (output.is_open())
+    {
+        output << "\n  ],\n  \"passed\": " << (passed ? "true" : "false") << "\n}\n";
+    }
+
+    std::cout << (passed ? "PASSED" : "FAILED: Throughput dropped more than the threshold.") << std::endl;
+    return passed;
+}
+
+}
+
+
+int main(int argc, const char* argv[])
+{
+    static const char USAGE[] =
+    R"(
+    Snake AI Performance Compare - Copyright (c) 2023-Present, Arkin Terli. All rights reserved.
+
+    Usage:
+        SnakeAIPerfCompare run --rss=<name> -- <command> [<args>...]
+        SnakeAIPerfCompare compare --baseline=<dir> --candidate=<dir> [--threshold=<percent>] [--output=<name>]
+
+    Commands:
+        run                     Runs a command and writes its peak resident memory (bytes) into a file.
+        compare                 Compares results of the runs of two builds. Exits with 1 if throughput of the
+                                candidate is significantly lower than the baseline by more than the threshold.
+
+    Options:
+        -h, --help              Show this screen.
+        --rss=<name>            Peak resident memory filename.
+        --baseline=<dir>        Result folder of the baseline build.
+        --candidate=<dir>       Result folder of the candidate build.
+        --threshold=<percent>   Maximum allowed throughput drop (%). [Default: 3]
+        --output=<name>         Comparison report filename in JSON format.
+    )";
+
+    try
+    {
+        std::vector<std::string>  args{argv + 1, argv + argc};
+        if (args.empty() || args[0] == "-h" || args[0] == "--help")
+        {
+            std::cout << USAGE << std::endl;
+            return 0;
+        }
+
+        std::map<std::string, std::string>  options;
+        std::vector<char *>  commandArgs;
+        for (std::size_t i=1; i<args.size(); ++i)
+        {
+            if (args[i] == "--")
+            {
+                for (std::size_t c=i+1; c<args.size(); ++c)
+                {
+                    commandArgs.emplace_back(const_cast<char *>(argv[c + 1]));
+                }
+                break;
+            }
+
+            auto separator = args[i].find('=');
+            if (separator == std::string::npos)
+            {
+                std::cerr << "Invalid commandline parameter usage. Please use '--help' parameter for more information." << std::endl;
+                return -1;
+            }
+            options[args[i].substr(0, separator)] = args[i].substr(separator + 1);
+        }
+
+        if (args[0] == "run" && options.count("--rss") && !commandArgs.empty())
+        {
+            return RunCommand(options["--rss"], commandArgs);
+        }
+        else if (args[0] == "compare" && options.count("--baseline") && options.count("--candidate"))
+        {
+            double threshold = options.count("--threshold") ? std::stod(options["--threshold"]) : 3;
+            return CompareRuns(options["--baseline"], options["--candidate"], threshold, options["--output"]) ? 0 : 1;
+        }
+
+        std::cerr << "Invalid commandline parameter usage. Please use '--help' parameter for more information." << std::endl;
+        return -1;
+    }
+    catch (std::exception & e)
+    {
+        std::cout << "EXCEPTION: " << e.what() << std::endl;
+        return -1;
+    }
+}
@@ -0,0 +1,303 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+// Project includes
+#include "AllocCounters.hpp"
+// External includes
+// System includes
+#if defined(SNAKEAI_ALLOC_COUNTERS)
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#endif
+
+
+#if defined(SNAKEAI_ALLOC_COUNTERS)
+
+#if defined(SNAKEAI_WRAP_MALLOC)
+// The linker redirects calls to the malloc family of all objects of the program to the __wrap_ functions below, and
+// the original functions are reachable as __real_.
+extern "C"
+{
+void * __real_malloc(std::size_t size);
+void * __real_calloc(std::size_t count, std::size_t size);
+void * __real_realloc(void * ptr, std::size_t size);
+void * __real_aligned_alloc(std::size_t alignment, std::size_t size);
+int    __real_posix_memalign(void ** ptr, std::size_t alignment, std::size_t size);
+void   __real_free(void * ptr);
+}
+#define SNAKEAI_MALLOC          __real_malloc
+#define SNAKEAI_POSIX_MEMALIGN  __real_posix_memalign
+#define SNAKEAI_FREE            __real_free
+#else
+#define SNAKEAI_MALLOC          std::malloc
+#define SNAKEAI_POSIX_MEMALIGN  posix_memalign
+#define SNAKEAI_FREE            std::free
+#endif
+
+namespace
+{
+
+// Counts of a thread. Slots are on separate cache lines, so threads don't share the lines they write.
+struct alignas(64) ThreadSlot
+{
+    std::atomic<uint64_t>  allocations{0};
+    std::atomic<uint64_t>  deallocations{0};
+    std::atomic<uint64_t>  bytes{0};
+};
+
+// Slots are never released, so the counts of exited threads remain in the totals. Threads beyond the capacity share
+// the last slot, which is still correct since the counters are atomic.
+constexpr std::size_t  kMaxThreadSlots = 1024;
+
+std::array<ThreadSlot, kMaxThreadSlots>  g_threadSlots;
+std::atomic<std::size_t>  g_threadSlotCount{0};
+
+// Returns the slot of the calling thread. It can't allocate since it's called by the operators.
+ThreadSlot & GetThreadSlot()
+{
+    thread_local ThreadSlot *  slot = nullptr;
+    if (slot == nullptr)
+    {
+        auto index = g_threadSlotCount.fetch_add(1, std::memory_order_relaxed);
+        slot = &g_threadSlots[std::min(index, kMaxThreadSlots - 1)];
+    }
+    return *slot;
+}
+
+void CountAllocation(std::size_t size)
+{
+    auto & slot = GetThreadSlot();
+    slot.allocations.fetch_add(1, std::memory_order_relaxed);
+    slot.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void CountDeallocation()
+{
+    GetThreadSlot().deallocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void * Allocate(std::size_t size, std::size_t alignment, bool noThrow)
+{
+    size = std::max<std::size_t>(size, 1);
+
+    for (;;)
+    {
+        void * ptr = nullptr;
+        if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            ptr = SNAKEAI_MALLOC(size);
+        }
+        else if (SNAKEAI_POSIX_MEMALIGN(&ptr, alignment, size) != 0)
+        {
+            ptr = nullptr;
+        }
+
+        if (ptr)
+        {
+            CountAllocation(size);
+            return ptr;
+        }
+
+        // Out of memory. The new handler can release memory and let the allocation be tried again.
+        auto newHandler = std::get_new_handler();
+        if (newHandler == nullptr)
+        {
+            if (noThrow)
+            {
+                return nullptr;
+            }
+            throw std::bad_alloc();
+        }
+        newHandler();
+    }
+}
+
+void Deallocate(void * ptr)
+{
+    if (ptr)
+    {
+        CountDeallocation();
+        SNAKEAI_FREE(ptr);
+    }
+}
+
+}
+
+
+// The counting operators replace the default ones of the program. They are in the same object file as the
+// AllocCounters functions, so the linker takes them from the static library together with the functions.
+
+void * operator new(std::size_t size)                                    { return Allocate(size, 0, false); }
+void * operator new[](std::size_t size)                                  { return Allocate(size, 0, false); }
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept   { return Allocate(size, 0, true); }
+void * operator new[](std::size_t size, const std::nothrow_t &) noexcept { return Allocate(size, 0, true); }
+
+void * operator new(std::size_t size, std::align_val_t alignment)
+{
+    return Allocate(size, static_cast<std::size_t>(alignment), false);
+}
+
+void * operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return Allocate(size, static_cast<std::size_t>(alignment), false);
+}
+
+void * operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return Allocate(size, static_cast<std::size_t>(alignment), true);
+}
+
+void * operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return Allocate(size, static_cast<std::size_t>(alignment), true);
+}
+
+void operator delete(void * ptr) noexcept                                             { Deallocate(ptr); }
+void operator delete[](void * ptr) noexcept                                           { Deallocate(ptr); }
+void operator delete(void * ptr, std::size_t) noexcept                                { Deallocate(ptr); }
+void operator delete[](void * ptr, std::size_t) noexcept                              { Deallocate(ptr); }
+void operator delete(void * ptr, const std::nothrow_t &) noexcept                     { Deallocate(ptr); }
+void operator delete[](void * ptr, const std::nothrow_t &) noexcept                   { Deallocate(ptr); }
+void operator delete(void * ptr, std::align_val_t) noexcept                           { Deallocate(ptr); }
+void operator delete[](void * ptr, std::align_val_t) noexcept                         { Deallocate(ptr); }
+void operator delete(void * ptr, std::size_t, std::align_val_t) noexcept              { Deallocate(ptr); }
+void operator delete[](void * ptr, std::size_t, std::align_val_t) noexcept            { Deallocate(ptr); }
+void operator delete(void * ptr, std::align_val_t, const std::nothrow_t &) noexcept   { Deallocate(ptr); }
+void operator delete[](void * ptr, std::align_val_t, const std::nothrow_t &) noexcept { Deallocate(ptr); }
+
+#if defined(SNAKEAI_WRAP_MALLOC)
+
+// Counting malloc family. Libraries that allocate with malloc directly, like Eigen, are counted by these.
+extern "C"
+{
+
+void * __wrap_malloc(std::size_t size)
+{
+    void * ptr = __real_malloc(size);
+    if (ptr)
+    {
+        CountAllocation(size);
+    }
+    return ptr;
+}
+
+void * __wrap_calloc(std::size_t count, std::size_t size)
+{
+    void * ptr = __real_calloc(count, size);
+    if (ptr)
+    {
+        CountAllocation(count * size);
+    }
+    return ptr;
+}
+
+// A reallocation is counted as a new allocation and the release of the old one.
+void * __wrap_realloc(void * ptr, std::size_t size)
+{
+    void * newPtr = __real_realloc(ptr, size);
+    if (newPtr)
+    {
+        CountAllocation(size);
+        if (ptr)
+        {
+            CountDeallocation();
+        }
+    }
+    return newPtr;
+}
+
+void * __wrap_aligned_alloc(std::size_t alignment, std::size_t size)
+{
+    void * ptr = __real_aligned_alloc(alignment, size);
+    if (ptr)
+    {
+        CountAllocation(size);
+    }
+    return ptr;
+}
+
+int __wrap_posix_memalign(void ** ptr, std::size_t alignment, std::size_t size)
+{
+    int result = __real_posix_memalign(ptr, alignment, size);
+    if (result == 0)
+    {
+        CountAllocation(size);
+    }
+    return result;
+}
+
+void __wrap_free(void * ptr)
+{
+    if (ptr)
+    {
+        CountDeallocation();
+    }
+    __real_free(ptr);
+}
+
+}
+
+#endif
+
+#endif
+
+
+bool AllocCounters::IsAvailable()
+{
+#if defined(SNAKEAI_ALLOC_COUNTERS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+AllocCounts AllocCounters::GetThreadCounts()
+{
+    AllocCounts  counts;
+#if defined(SNAKEAI_ALLOC_COUNTERS)
+    const auto & slot = GetThreadSlot();
+    counts.allocations   = slot.allocations.load(std::memory_order_relaxed);
+    counts.deallocations = slot.deallocations.load(std::memory_order_relaxed);
+    counts.bytes         = slot.bytes.load(std::memory_order_relaxed);
+#endif
+    return counts;
+}
+
+
+AllocCounts AllocCounters::GetCounts()
+{
+    AllocCounts  counts;
+#if defined(SNAKEAI_ALLOC_COUNTERS)
+    auto slotCount = std::min(g_threadSlotCount.load(std::memory_order_relaxed), kMaxThreadSlots);
+    for (std::size_t i=0; i<slotCount; ++i)
+    {
+        counts.allocations   += g_threadSlots[i].allocations.load(std::memory_order_relaxed);
+        counts.deallocations += g_threadSlots[i].deallocations.load(std::memory_order_relaxed);
+        counts.bytes         += g_threadSlots[i].bytes.load(std::memory_order_relaxed);
+    }
+#endif
+    return counts;
+}
+
+
+void AllocCounters::AddCounts(const AllocCounts & counts)
+{
+#if defined(SNAKEAI_ALLOC_COUNTERS)
+    auto & slot = GetThreadSlot();
+    slot.allocations.fetch_add(counts.allocations, std::memory_order_relaxed);
+    slot.deallocations.fetch_add(counts.deallocations, std::memory_order_relaxed);
+    slot.bytes.fetch_add(counts.bytes, std::memory_order_relaxed);
+#else
+    (void)counts;
+#endif
+}
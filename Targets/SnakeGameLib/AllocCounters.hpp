@@ -0,0 +1,71 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#pragma once
+
+// Project includes
+// External includes
+// System includes
+#include <cstdint>
+
+
+// Heap allocation counts.
+struct AllocCounts
+{
+    AllocCounts operator-(const AllocCounts & other) const
+    {
+        return {allocations - other.allocations, deallocations - other.deallocations, bytes - other.bytes};
+    }
+
+    uint64_t  allocations{0};
+    uint64_t  deallocations{0};
+    uint64_t  bytes{0};         // Requested bytes of the allocations.
+};
+
+
+// Counts heap allocations made with operator new and released with operator delete. The counting operators are
+// compiled only if the SNAKEAI_ALLOC_COUNTERS build option is on, otherwise all counts are zero. Each thread counts
+// into its own slot, so counting doesn't add contention between threads. On Linux, calls to the malloc family from
+// the objects of the program, like Eigen matrices, are counted too by wrapping them at link time. Allocations made
+// inside shared libraries are not counted.
+class AllocCounters
+{
+public:
+    // Returns true if the counting operators are compiled in.
+    static bool IsAvailable();
+
+    // Returns counts of the calling thread since the thread started.
+    static AllocCounts GetThreadCounts();
+
+    // Returns counts of all threads since the process started, including the threads that have exited.
+    static AllocCounts GetCounts();
+
+    // Adds counts of allocations made by other processes for this process, like worker processes, to the calling
+    // thread. Does nothing if the counting operators are not compiled in.
+    static void AddCounts(const AllocCounts & counts);
+};
+
+
+// Measures allocations of all threads from construction.
+class AllocScope
+{
+public:
+    AllocScope() : m_begin{AllocCounters::GetCounts()}
+    {
+    }
+
+    // Returns counts since construction.
+    AllocCounts GetCounts() const
+    {
+        return AllocCounters::GetCounts() - m_begin;
+    }
+
+private:
+    AllocCounts  m_begin;
+};
@@ -0,0 +1,139 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+
+// Project includes
+#include "BatchedFFNN.hpp"
+#include "Kernels.hpp"
+// External includes
+// System includes
+#include <algorithm>
+#include <stdexcept>
+
+
+BatchedFFNN::BatchedFFNN(const std::vector<int> & layers, const std::vector<ActivationType> & activations,
+                         std::size_t networkCount) :
+    m_layers{layers},
+    m_networkCount{networkCount}
+{
+    if (layers.size() < 3 || activations.size() < 2 || layers.size() - 1 != activations.size() || networkCount == 0)
+    {
+        throw std::runtime_error("Layer configuration is not correct");
+    }
+
+    for (size_t i=0; i<layers.size()-1; ++i)
+    {
+        m_weights.emplace_back(std::size_t(layers[i]) * layers[i+1] * networkCount, 0);
+        m_biases.emplace_back(std::size_t(layers[i+1]) * networkCount, 0);
+        m_activations.emplace_back(ActivationFactory::Create(activations[i]));
+    }
+}
+
+
+BatchedFFNN::~BatchedFFNN()
+{
+    DeleteActivations();
+}
+
+
+bool BatchedFFNN::DeserializeAllParameters(std::size_t network, std::span<const double> vector)
+{
+    using RowMajorMatrixXd = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+    if (network >= m_networkCount)
+    {
+        return false;
+    }
+
+    std::size_t totalSize = 0;
+    for (std::size_t i=0; i<m_weights.size(); ++i)
+    {
+        totalSize += (m_weights[i].size() + m_biases[i].size()) / m_networkCount;
+    }
+
+    if (vector.size() != totalSize)
+    {
+        return false;
+    }
+
+    // All weights are serialized first as column-major matrices, then all biases.
+    const double * src = vector.data();
+    for (std::size_t i=0; i<m_weights.size(); ++i)
+    {
+        Eigen::Index rows = m_layers[i];
+        Eigen::Index cols = m_layers[i+1];
+        double * dst = m_weights[i].data() + rows * cols * network;
+        Eigen::Map<RowMajorMatrixXd>(dst, rows, cols) = Eigen::Map<const Eigen::MatrixXd>(src, rows, cols);
+        src += rows * cols;
+    }
+
+    for (std::size_t i=0; i<m_biases.size(); ++i)
+    {
+        std::size_t cols = m_layers[i+1];
+        std::copy(src, src + cols, m_biases[i].data() + cols * network);
+        src += cols;
+    }
+
+    return true;
+}
+
+
+Eigen::MatrixXd BatchedFFNN::Forward(const Eigen::MatrixXd & input, const std::vector<Eigen::Index> & rowCounts)
+{
+    using RowMajorMatrixXd = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+    if (rowCounts.size() != m_networkCount)
+    {
+        throw std::runtime_error("Row counts must be given for each network.");
+    }
+
+    const auto & kernels = kernels::GetKernels();
+
+    RowMajorMatrixXd H = input;
+    RowMajorMatrixXd next;
+    for (size_t i=0; i<m_weights.size(); ++i)
+    {
+        std::size_t inputSize  = m_layers[i];
+        std::size_t outputSize = m_layers[i+1];
+        next.resize(H.rows(), static_cast<Eigen::Index>(outputSize));
+
+        // Rows of each network are contiguous in row-major matrices.
+        std::size_t firstRow = 0;
+        for (std::size_t n=0; n<m_networkCount; ++n)
+        {
+            auto rows = static_cast<std::size_t>(rowCounts[n]);
+            if (rows == 0)
+            {
+                continue;
+            }
+
+            kernels.denseForward(H.data() + firstRow * inputSize, rows, inputSize,
+                                 m_weights[i].data() + inputSize * outputSize * n,
+                                 m_biases[i].data() + outputSize * n, outputSize,
+                                 next.data() + firstRow * outputSize);
+            firstRow += rows;
+        }
+
+        // Apply activation. Activations are element-wise or row-wise, so all networks are processed at once.
+        m_activations[i]->Calculate(next.data(), static_cast<std::size_t>(next.rows()), outputSize);
+        H.swap(next);
+    }
+
+    return H;
+}
+
+
+void BatchedFFNN::DeleteActivations()
+{
+    for (auto activation : m_activations)
+    {
+        delete activation;
+    }
+    m_activations.clear();
+}
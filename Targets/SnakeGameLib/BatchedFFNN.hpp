@@ -0,0 +1,57 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#pragma once
+
+// Project includes
+#include "FFNN.hpp"
+// External includes
+#include <Eigen/Dense>
+// System includes
+#include <span>
+#include <vector>
+
+
+// Evaluates many feed-forward neural networks with the same topology at once. Parameters of all networks are stacked
+// per layer, so a layer step of all networks runs over contiguous buffers instead of one small product per network.
+class BatchedFFNN
+{
+public:
+    // Constructor
+    BatchedFFNN(const std::vector<int> & layers, const std::vector<ActivationType> & activations,
+                std::size_t networkCount);
+
+    // Copying would share activation objects.
+    BatchedFFNN(const BatchedFFNN &) = delete;
+    BatchedFFNN & operator=(const BatchedFFNN &) = delete;
+
+    // Destructor
+    virtual ~BatchedFFNN();
+
+    // Returns number of networks.
+    std::size_t GetNetworkCount() const { return m_networkCount; }
+
+    // Sets all parameters, weights + biases, of a network. Uses the same layout as FFNN::SerializeAllParameters().
+    bool DeserializeAllParameters(std::size_t network, std::span<const double> vector);
+
+    // Makes predictions of all networks. Input rows are grouped by network: the first rowCounts[0] rows are predicted
+    // by network 0, the next rowCounts[1] rows by network 1 and so on. Output rows follow the same order.
+    Eigen::MatrixXd Forward(const Eigen::MatrixXd & input, const std::vector<Eigen::Index> & rowCounts);
+
+private:
+    // Deletes all activations.
+    void DeleteActivations();
+
+private:
+    std::vector<int>                  m_layers;
+    std::vector<std::vector<double>>  m_weights;     // Per layer: row-major (input size x output size) per network.
+    std::vector<std::vector<double>>  m_biases;      // Per layer: output size per network.
+    std::vector<ActivationBase*>      m_activations;
+    std::size_t                   m_networkCount;
+};
@@ -0,0 +1,403 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#pragma once
+
+// Project includes
+#include <RandomStream.hpp>
+#include <ThreadPool.hpp>
+// External includes
+#include <Eigen/Dense>
+// System includes
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+namespace es
+{
+
+// Covariance models of CMA-ES.
+enum class CovarianceModel : int32_t
+{
+    kCovarianceModelFull      = 0,    // Full covariance matrix. Learns correlations between all parameters.
+    kCovarianceModelSeparable = 1,    // Diagonal covariance matrix (sep-CMA-ES). Linear time and memory per sample.
+};
+
+
+// Covariance matrix adaptation evolution strategy that maximizes fitness. Each generation samples lambda candidates
+// from N(m, sigma^2 C) and moves the mean towards the best mu of them. The covariance matrix is adapted by rank-one
+// and rank-mu updates and the step size by cumulative step-size adaptation.
+// Candidate k of generation g is drawn from the random stream (seed, g, k), so results don't depend on the number of
+// threads or on the order the tasks run.
+class CMAES
+{
+public:
+    // Constructor. sampleCount is lambda. Zero selects the default 4 + 3 ln(dimension).
+    CMAES(std::size_t dimension, std::size_t sampleCount, double sigma, CovarianceModel model) :
+            m_dimension{dimension},
+            m_sampleCount{sampleCount},
+            m_sigma{sigma},
+            m_model{model},
+            m_mean(Eigen::VectorXd::Zero(static_cast<Eigen::Index>(dimension)))
+    {
+        if (m_dimension == 0)
+        {
+            throw std::runtime_error("CMA-ES dimension must be greater than zero.");
+        }
+        if (m_sampleCount == 0)
+        {
+            m_sampleCount = 4 + static_cast<std::size_t>(3 * std::log(double(m_dimension)));
+        }
+        m_sampleCount = std::max<std::size_t>(m_sampleCount, 2);
+
+        std::random_device  rndDev;
+        m_seed = (static_cast<uint64_t>(rndDev()) << 32) | rndDev();
+
+        m_threadCount = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    void SetFitnessFunc(std::function<double(std::span<const double> value)>&& func)
+    {
+        m_fitnessFunc = std::move(func);
+    }
+
+    // Sets a function that evaluates all candidates of a generation on the thread pool. It's used instead of the
+    // fitness function if set.
+    void SetPopulationFitnessFunc(std::function<std::vector<double>(const std::vector<std::span<const double>> & values,
+                                                                    ThreadPool & threadPool)>&& func)
+    {
+        m_populationFitnessFunc = std::move(func);
+    }
+
+    void SetSeed(uint64_t seed)
+    {
+        m_seed = seed;
+    }
+
+    // Sets the initial mean. Zero vector is used if not set.
+    void SetMean(std::span<const double> mean)
+    {
+        if (mean.size() != m_dimension)
+        {
+            throw std::runtime_error("CMA-ES mean size does not match the dimension.");
+        }
+        m_mean = Eigen::Map<const Eigen::VectorXd>(mean.data(), static_cast<Eigen::Index>(mean.size()));
+    }
+
+    void CreateInitialPopulation()
+    {
+        Initialize();
+
+        m_generation = 1;
+        Evolve();
+    }
+
+    void CreateNextPopulation()
+    {
+        m_generation++;
+        Evolve();
+    }
+
+    // Returns the best candidate found so far.
+    std::span<const double> GetBestSolution() const
+    {
+        return m_bestSolution;
+    }
+
+    double GetBestFitness() const
+    {
+        return m_bestFitness;
+    }
+
+    std::size_t GetGeneration() const
+    {
+        return m_generation;
+    }
+
+    // Returns the number of candidates evaluated in each generation (lambda).
+    std::size_t GetSampleCount() const
+    {
+        return m_sampleCount;
+    }
+
+    // Returns the current step size.
+    double GetSigma() const
+    {
+        return m_sigma;
+    }
+
+private:
+    void Initialize()
+    {
+        auto n = static_cast<double>(m_dimension);
+        auto dim = static_cast<Eigen::Index>(m_dimension);
+
+        // Recombination weights of the best mu candidates.
+        m_parentCount = m_sampleCount / 2;
+        m_weights.resize(static_cast<Eigen::Index>(m_parentCount));
+        for (std::size_t i=0; i<m_parentCount; ++i)
+        {
+            m_weights[static_cast<Eigen::Index>(i)] = std::log(double(m_sampleCount + 1) / 2) - std::log(double(i + 1));
+        }
+        m_weights /= m_weights.sum();
+        m_muEff = 1 / m_weights.squaredNorm();
+
+        // Learning rates. Default settings of Hansen's CMA-ES tutorial.
+        m_cSigma = (m_muEff + 2) / (n + m_muEff + 5);
+        m_dSigma = 1 + 2 * std::max(0.0, std::sqrt((m_muEff - 1) / (n + 1)) - 1) + m_cSigma;
+        m_cc = (4 + m_muEff / n) / (n + 4 + 2 * m_muEff / n);
+        m_c1 = 2 / ((n + 1.3) * (n + 1.3) + m_muEff);
+        m_cMu = std::min(1 - m_c1, 2 * (m_muEff - 2 + 1 / m_muEff) / ((n + 2) * (n + 2) + m_muEff));
+        m_chiN = std::sqrt(n) * (1 - 1 / (4 * n) + 1 / (21 * n * n));
+
+        if (m_model == CovarianceModel::kCovarianceModelSeparable)
+        {
+            // A diagonal matrix has only n parameters to learn, so it can learn faster (Ros & Hansen, 2008).
+            m_c1  = std::min(1.0, m_c1 * (n + 2) / 3);
+            m_cMu = std::min(1 - m_c1, m_cMu * (n + 2) / 3);
+        }
+        else
+        {
+            m_covariance = Eigen::MatrixXd::Identity(dim, dim);
+            m_eigenVectors = Eigen::MatrixXd::Identity(dim, dim);
+            m_eigenGeneration = 0;
+        }
+
+        m_variances = Eigen::VectorXd::Ones(dim);
+        m_scales = Eigen::VectorXd::Ones(dim);
+        m_sigmaPath = Eigen::VectorXd::Zero(dim);
+        m_covariancePath = Eigen::VectorXd::Zero(dim);
+
+        m_candidates.resize(dim, static_cast<Eigen::Index>(m_sampleCount));
+        m_steps.resize(dim, static_cast<Eigen::Index>(m_sampleCount));
+        m_fitness.assign(m_sampleCount, 0);
+
+        m_bestSolution.assign(m_dimension, 0);
+        m_bestFitness = -std::numeric_limits<double>::max();
+
+        m_threadPool = std::make_unique<ThreadPool>(m_threadCount);
+    }
+
+    void Evolve()
+    {
+        SampleCandidates();
+        CalculateFitnessValues();
+        Update();
+    }
+
+    // Draws candidates x = m + sigma * y, where y ~ N(0, C).
+    void SampleCandidates()
+    {
+        Eigen::VectorXd  z(static_cast<Eigen::Index>(m_dimension));
+
+        for (std::size_t k=0; k<m_sampleCount; ++k)
+        {
+            ga::RandomStream  rng(m_seed, static_cast<uint32_t>(m_generation), static_cast<uint32_t>(k));
+            for (Eigen::Index i=0; i<z.size(); ++i)
+            {
+                z[i] = rng.Normal();
+            }
+
+            auto column = static_cast<Eigen::Index>(k);
+            if (m_model == CovarianceModel::kCovarianceModelSeparable)
+            {
+                m_steps.col(column) = m_scales.cwiseProduct(z);
+            }
+            else
+            {
+                m_steps.col(column).noalias() = m_eigenVectors * m_scales.cwiseProduct(z);
+            }
+            m_candidates.col(column) = m_mean + m_sigma * m_steps.col(column);
+        }
+    }
+
+    // Calculates fitness values of all candidates in parallel.
+    void CalculateFitnessValues()
+    {
+        std::vector<std::span<const double>>  values;
+        for (std::size_t k=0; k<m_sampleCount; ++k)
+        {
+            values.emplace_back(m_candidates.col(static_cast<Eigen::Index>(k)).data(), m_dimension);
+        }
+
+        if (m_populationFitnessFunc)
+        {
+            m_fitness = m_populationFitnessFunc(values, *m_threadPool);
+            if (m_fitness.size() != values.size())
+            {
+                throw std::runtime_error("Population fitness function returned wrong number of values.");
+            }
+        }
+        else
+        {
+            std::vector<std::future<void>>  results;
+            for (std::size_t k=0; k<m_sampleCount; ++k)
+            {
+                results.emplace_back(m_threadPool->Enqueue([&](std::size_t k)
+                {
+                    m_fitness[k] = m_fitnessFunc(values[k]);
+                }, k));
+            }
+
+            // Wait until all tasks are finished.
+            for (auto & result : results)
+            {
+                result.wait();
+                result.get();     // We don't have a return value but this will rethrow an uncaught exception.
+            }
+        }
+
+        for (std::size_t k=0; k<m_sampleCount; ++k)
+        {
+            if (m_fitness[k] > m_bestFitness)
+            {
+                m_bestFitness = m_fitness[k];
+                auto column = m_candidates.col(static_cast<Eigen::Index>(k));
+                std::copy(column.data(), column.data() + m_dimension, m_bestSolution.begin());
+            }
+        }
+    }
+
+    // Moves the mean towards the best candidates and adapts the step size and the covariance matrix.
+    void Update()
+    {
+        auto n = static_cast<double>(m_dimension);
+
+        // Rank candidates by fitness. Ties are broken by index to keep runs reproducible.
+        std::vector<std::size_t>  ranking(m_sampleCount);
+        std::iota(ranking.begin(), ranking.end(), 0);
+        std::sort(ranking.begin(), ranking.end(), [&](std::size_t left, std::size_t right)
+        {
+            return m_fitness[left] > m_fitness[right] || (m_fitness[left] == m_fitness[right] && left < right);
+        });
+
+        Eigen::MatrixXd  parentSteps(m_steps.rows(), static_cast<Eigen::Index>(m_parentCount));
+        for (std::size_t i=0; i<m_parentCount; ++i)
+        {
+            parentSteps.col(static_cast<Eigen::Index>(i)) = m_steps.col(static_cast<Eigen::Index>(ranking[i]));
+        }
+
+        Eigen::VectorXd  meanStep = parentSteps * m_weights;
+        m_mean += m_sigma * meanStep;
+
+        // Evolution path of the step size uses C^-1/2 * meanStep, which is isotropic under random selection.
+        Eigen::VectorXd  whitenedStep;
+        if (m_model == CovarianceModel::kCovarianceModelSeparable)
+        {
+            whitenedStep = meanStep.cwiseQuotient(m_scales);
+        }
+        else
+        {
+            whitenedStep = m_eigenVectors * (m_eigenVectors.transpose() * meanStep).cwiseQuotient(m_scales);
+        }
+        m_sigmaPath = (1 - m_cSigma) * m_sigmaPath + std::sqrt(m_cSigma * (2 - m_cSigma) * m_muEff) * whitenedStep;
+
+        // Stall the rank-one update if the step size grows too fast.
+        double sigmaPathNorm = m_sigmaPath.norm();
+        double expectedNorm = std::sqrt(1 - std::pow(1 - m_cSigma, 2.0 * double(m_generation))) * m_chiN;
+        bool   hSigma = sigmaPathNorm / expectedNorm < 1.4 + 2 / (n + 1);
+
+        m_covariancePath = (1 - m_cc) * m_covariancePath;
+        if (hSigma)
+        {
+            m_covariancePath += std::sqrt(m_cc * (2 - m_cc) * m_muEff) * meanStep;
+        }
+        double stallCorrection = hSigma ? 0 : m_c1 * m_cc * (2 - m_cc);
+
+        if (m_model == CovarianceModel::kCovarianceModelSeparable)
+        {
+            m_variances = (1 - m_c1 - m_cMu + stallCorrection) * m_variances +
+                          m_c1 * m_covariancePath.cwiseAbs2() +
+                          m_cMu * parentSteps.cwiseAbs2() * m_weights;
+            m_scales = m_variances.cwiseSqrt();
+        }
+        else
+        {
+            m_covariance *= 1 - m_c1 - m_cMu + stallCorrection;
+            m_covariance.selfadjointView<Eigen::Lower>().rankUpdate(m_covariancePath, m_c1);
+            m_covariance.selfadjointView<Eigen::Lower>().rankUpdate(parentSteps * m_weights.cwiseSqrt().asDiagonal(),
+                                                                    m_cMu);
+
+            // Eigendecomposition costs O(n^3), so it's updated only as often as C changes noticeably.
+            double eigenInterval = 1 / ((m_c1 + m_cMu) * n * 10);
+            if (double(m_generation - m_eigenGeneration) > eigenInterval)
+            {
+                UpdateEigenDecomposition();
+            }
+        }
+
+        m_sigma *= std::exp((m_cSigma / m_dSigma) * (sigmaPathNorm / m_chiN - 1));
+    }
+
+    // Decomposes C = B * D^2 * B^T. Only the lower triangle of C is kept up to date.
+    void UpdateEigenDecomposition()
+    {
+        m_eigenGeneration = m_generation;
+
+        Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd>  solver(m_covariance, Eigen::ComputeEigenvectors);
+        m_eigenVectors = solver.eigenvectors();
+        m_variances = solver.eigenvalues().cwiseMax(std::numeric_limits<double>::min());
+        m_scales = m_variances.cwiseSqrt();
+    }
+
+private:
+    std::size_t  m_dimension;
+    std::size_t  m_sampleCount;
+    std::size_t  m_parentCount{0};
+    double       m_sigma;
+    CovarianceModel  m_model;
+    uint64_t     m_seed;
+    std::size_t  m_generation{0};
+    std::size_t  m_threadCount;
+
+    // Strategy parameters.
+    Eigen::VectorXd  m_weights;
+    double  m_muEff{0};
+    double  m_cSigma{0};
+    double  m_dSigma{0};
+    double  m_cc{0};
+    double  m_c1{0};
+    double  m_cMu{0};
+    double  m_chiN{0};
+
+    // Distribution state. Separable model keeps only the diagonal in m_variances.
+    Eigen::VectorXd  m_mean;
+    Eigen::VectorXd  m_sigmaPath;
+    Eigen::VectorXd  m_covariancePath;
+    Eigen::MatrixXd  m_covariance;
+    Eigen::MatrixXd  m_eigenVectors;
+    Eigen::VectorXd  m_variances;       // Eigenvalues of C.
+    Eigen::VectorXd  m_scales;          // Square roots of the eigenvalues.
+    std::size_t      m_eigenGeneration{0};
+
+    // Candidates of the current generation, one per column.
+    Eigen::MatrixXd      m_candidates;
+    Eigen::MatrixXd      m_steps;
+    std::vector<double>  m_fitness;
+
+    std::vector<double>  m_bestSolution;
+    double               m_bestFitness{-std::numeric_limits<double>::max()};
+
+    std::unique_ptr<ThreadPool>  m_threadPool;
+    std::function<double(std::span<const double> value)>   m_fitnessFunc;
+    std::function<std::vector<double>(const std::vector<std::span<const double>> & values,
+                                      ThreadPool & threadPool)>   m_populationFitnessFunc;
+};
+
+} // namespace es
@@ -0,0 +1,31 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#pragma once
+
+// Project includes
+#include "AllocCounters.hpp"
+// External includes
+// System includes
+#include <cstdint>
+#include <type_traits>
+
+
+// Result of a fitness evaluation done in a worker process or on a remote worker. Counters of the work done by the
+// evaluation are sent back with the fitness value, since counters of other processes are not visible.
+struct EvaluationResult
+{
+    double    fitness{0};
+    uint64_t  games{0};
+    uint64_t  steps{0};
+    uint64_t  forwardCalls{0};
+    AllocCounts  allocCounts;
+};
+
+static_assert(std::is_trivially_copyable_v<EvaluationResult>, "Evaluation results are copied as raw bytes.");
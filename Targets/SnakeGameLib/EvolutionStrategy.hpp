@@ -0,0 +1,385 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#pragma once
+
+// Project includes
+#include <RandomStream.hpp>
+#include <ThreadPool.hpp>
+// External includes
+// System includes
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+namespace es
+{
+
+// Large block of standard normal noise shared by all workers. A perturbation of n parameters is the n consecutive
+// values at an offset, so it's identified by a single integer.
+class NoiseTable
+{
+public:
+    // Fills the table of the given size from the seed. Values are generated in parallel on the thread pool and don't
+    // depend on the number of threads.
+    void Create(std::size_t size, uint64_t seed, ThreadPool & threadPool)
+    {
+        m_noise.resize(size);
+
+        std::vector<std::future<void>>  results;
+        for (std::size_t first=0; first<size; first += kChunkSize)
+        {
+            results.emplace_back(threadPool.Enqueue([this, seed, size](std::size_t first)
+            {
+                ga::RandomStream  rng(seed, kNoiseStream, static_cast<uint32_t>(first / kChunkSize));
+                std::size_t last = std::min(first + kChunkSize, size);
+                for (std::size_t i=first; i<last; ++i)
+                {
+                    m_noise[i] = static_cast<float>(rng.Normal());
+                }
+            }, first));
+        }
+
+        // Wait until all tasks are finished.
+        for (auto & result : results)
+        {
+            result.wait();
+            result.get();     // We don't have a return value but this will rethrow an uncaught exception.
+        }
+    }
+
+    std::size_t GetSize() const
+    {
+        return m_noise.size();
+    }
+
+    // Returns count values starting at the offset.
+    std::span<const float> Get(std::size_t offset, std::size_t count) const
+    {
+        return {m_noise.data() + offset, count};
+    }
+
+    // Returns a random offset of a perturbation with count values.
+    std::size_t SampleOffset(ga::RandomStream & rng, std::size_t count) const
+    {
+        return rng.UniformIndex(m_noise.size() - count + 1);
+    }
+
+private:
+    static constexpr std::size_t  kChunkSize = 65536;
+    // Generation id of the noise stream. The trainers draw their game seeds and the initial mean from 0xFFFFFFFF and
+    // the genetic algorithm draws its island seeds from 0xFFFFFFFE.
+    static constexpr uint32_t     kNoiseStream = 0xFFFFFFFD;
+
+    std::vector<float>  m_noise;
+};
+
+
+// Natural evolution strategy in the style of OpenAI-ES that maximizes fitness. Each generation evaluates antithetic
+// pairs of candidates (mean + sigma * e, mean - sigma * e), where e comes from the shared noise table. Fitness values
+// are replaced by centered ranks and the mean follows the estimated gradient with the Adam optimizer.
+// A candidate is only a noise table offset until a worker materializes it into its own buffer, so memory per
+// candidate is constant. Results don't depend on the number of threads.
+class EvolutionStrategy
+{
+public:
+    // Constructor. pairCount antithetic pairs are evaluated in each generation.
+    EvolutionStrategy(std::size_t dimension, std::size_t pairCount, double sigma, double learningRate,
+                      std::size_t noiseTableSize) :
+            m_dimension{dimension},
+            m_pairCount{pairCount},
+            m_sigma{sigma},
+            m_learningRate{learningRate},
+            m_noiseTableSize{noiseTableSize},
+            m_mean(dimension, 0)
+    {
+        if (m_dimension == 0 || m_pairCount == 0)
+        {
+            throw std::runtime_error("Evolution strategy dimension and pair count must be greater than zero.");
+        }
+        if (m_noiseTableSize < m_dimension)
+        {
+            throw std::runtime_error("Noise table is smaller than the dimension.");
+        }
+
+        std::random_device  rndDev;
+        m_seed = (static_cast<uint64_t>(rndDev()) << 32) | rndDev();
+
+        m_threadCount = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    void SetFitnessFunc(std::function<double(std::span<const double> value)>&& func)
+    {
+        m_fitnessFunc = std::move(func);
+    }
+
+    void SetSeed(uint64_t seed)
+    {
+        m_seed = seed;
+    }
+
+    // Sets the initial mean. Zero vector is used if not set.
+    void SetMean(std::span<const double> mean)
+    {
+        if (mean.size() != m_dimension)
+        {
+            throw std::runtime_error("Evolution strategy mean size does not match the dimension.");
+        }
+        m_mean.assign(mean.begin(), mean.end());
+    }
+
+    // Sets L2 regularization coefficient of the update.
+    void SetWeightDecay(double weightDecay)
+    {
+        m_weightDecay = weightDecay;
+    }
+
+    void CreateInitialPopulation()
+    {
+        Initialize();
+
+        m_generation = 1;
+        Evolve();
+    }
+
+    void CreateNextPopulation()
+    {
+        m_generation++;
+        Evolve();
+    }
+
+    // Returns the best candidate found so far.
+    std::span<const double> GetBestSolution() const
+    {
+        return m_bestSolution;
+    }
+
+    double GetBestFitness() const
+    {
+        return m_bestFitness;
+    }
+
+    std::size_t GetGeneration() const
+    {
+        return m_generation;
+    }
+
+    // Returns the number of candidates evaluated in each generation.
+    std::size_t GetSampleCount() const
+    {
+        return m_pairCount * 2;
+    }
+
+private:
+    // Result of an antithetic pair.
+    struct PairResult
+    {
+        std::size_t  offset{0};
+        double       positiveFitness{0};
+        double       negativeFitness{0};
+    };
+
+    void Initialize()
+    {
+        m_threadPool = std::make_unique<ThreadPool>(m_threadCount);
+        m_noiseTable.Create(m_noiseTableSize, m_seed, *m_threadPool);
+
+        m_firstMoment.assign(m_dimension, 0);
+        m_secondMoment.assign(m_dimension, 0);
+        m_results.resize(m_pairCount);
+
+        m_bestSolution.assign(m_dimension, 0);
+        m_bestFitness = -std::numeric_limits<double>::max();
+    }
+
+    void Evolve()
+    {
+        CalculateFitnessValues();
+        Update();
+    }
+
+    // Evaluates all antithetic pairs in parallel.
+    void CalculateFitnessValues()
+    {
+        std::vector<std::future<void>>  results;
+        for (std::size_t p=0; p<m_pairCount; ++p)
+        {
+            results.emplace_back(m_threadPool->Enqueue([&](std::size_t p)
+            {
+                thread_local std::vector<double>  candidate;
+
+                ga::RandomStream  rng(m_seed, static_cast<uint32_t>(m_generation), static_cast<uint32_t>(p));
+                auto & result = m_results[p];
+                result.offset = m_noiseTable.SampleOffset(rng, m_dimension);
+
+                CreateCandidate(result.offset, 1, candidate);
+                result.positiveFitness = m_fitnessFunc(candidate);
+
+                CreateCandidate(result.offset, -1, candidate);
+                result.negativeFitness = m_fitnessFunc(candidate);
+            }, p));
+        }
+
+        // Wait until all tasks are finished.
+        for (auto & result : results)
+        {
+            result.wait();
+            result.get();     // We don't have a return value but this will rethrow an uncaught exception.
+        }
+
+        // Only the best candidate is materialized again to keep it.
+        for (const auto & result : m_results)
+        {
+            if (result.positiveFitness > m_bestFitness)
+            {
+                m_bestFitness = result.positiveFitness;
+                CreateCandidate(result.offset, 1, m_bestSolution);
+            }
+            if (result.negativeFitness > m_bestFitness)
+            {
+                m_bestFitness = result.negativeFitness;
+                CreateCandidate(result.offset, -1, m_bestSolution);
+            }
+        }
+    }
+
+    // Materializes the candidate mean + sign * sigma * noise.
+    void CreateCandidate(std::size_t offset, double sign, std::vector<double> & candidate) const
+    {
+        auto noise = m_noiseTable.Get(offset, m_dimension);
+
+        candidate.resize(m_dimension);
+        for (std::size_t i=0; i<m_dimension; ++i)
+        {
+            candidate[i] = m_mean[i] + sign * m_sigma * noise[i];
+        }
+    }
+
+    // Moves the mean along the estimated gradient.
+    void Update()
+    {
+        // Centered ranks in [-0.5, 0.5] make the update invariant to the scale of fitness values.
+        std::size_t sampleCount = m_pairCount * 2;
+        std::vector<std::size_t>  ranking(sampleCount);
+        std::iota(ranking.begin(), ranking.end(), 0);
+
+        auto Fitness = [&](std::size_t index)
+        {
+            const auto & result = m_results[index / 2];
+            return index % 2 == 0 ? result.positiveFitness : result.negativeFitness;
+        };
+        std::sort(ranking.begin(), ranking.end(), [&](std::size_t left, std::size_t right)
+        {
+            return Fitness(left) < Fitness(right) || (Fitness(left) == Fitness(right) && left < right);
+        });
+
+        std::vector<double>  ranks(sampleCount);
+        for (std::size_t r=0; r<sampleCount; ++r)
+        {
+            ranks[ranking[r]] = sampleCount > 1 ? double(r) / double(sampleCount - 1) - 0.5 : 0;
+        }
+
+        // Gradient is the weighted sum of the noise vectors. Pairs are reduced in fixed-size chunks and the partial
+        // sums are added in chunk order, so the result doesn't depend on the number of threads.
+        std::size_t chunkCount = (m_pairCount + kReductionChunkSize - 1) / kReductionChunkSize;
+        std::vector<std::vector<double>>  partialSums(chunkCount);
+
+        std::vector<std::future<void>>  results;
+        for (std::size_t c=0; c<chunkCount; ++c)
+        {
+            results.emplace_back(m_threadPool->Enqueue([&](std::size_t c)
+            {
+                auto & sum = partialSums[c];
+                sum.assign(m_dimension, 0);
+
+                std::size_t last = std::min((c + 1) * kReductionChunkSize, m_pairCount);
+                for (std::size_t p=c * kReductionChunkSize; p<last; ++p)
+                {
+                    double weight = ranks[p * 2] - ranks[p * 2 + 1];
+                    auto noise = m_noiseTable.Get(m_results[p].offset, m_dimension);
+                    for (std::size_t i=0; i<m_dimension; ++i)
+                    {
+                        sum[i] += weight * noise[i];
+                    }
+                }
+            }, c));
+        }
+
+        // Wait until all tasks are finished.
+        for (auto & result : results)
+        {
+            result.wait();
+            result.get();     // We don't have a return value but this will rethrow an uncaught exception.
+        }
+
+        std::vector<double>  gradient(m_dimension, 0);
+        for (const auto & sum : partialSums)
+        {
+            for (std::size_t i=0; i<m_dimension; ++i)
+            {
+                gradient[i] += sum[i];
+            }
+        }
+
+        // Adam step towards higher fitness.
+        constexpr double beta1 = 0.9;
+        constexpr double beta2 = 0.999;
+        constexpr double epsilon = 1e-8;
+
+        double scale = 1 / (double(sampleCount) * m_sigma);
+        double correction1 = 1 - std::pow(beta1, double(m_generation));
+        double correction2 = 1 - std::pow(beta2, double(m_generation));
+
+        for (std::size_t i=0; i<m_dimension; ++i)
+        {
+            double g = gradient[i] * scale - m_weightDecay * m_mean[i];
+            m_firstMoment[i]  = beta1 * m_firstMoment[i]  + (1 - beta1) * g;
+            m_secondMoment[i] = beta2 * m_secondMoment[i] + (1 - beta2) * g * g;
+            m_mean[i] += m_learningRate * (m_firstMoment[i] / correction1) /
+                         (std::sqrt(m_secondMoment[i] / correction2) + epsilon);
+        }
+    }
+
+private:
+    static constexpr std::size_t  kReductionChunkSize = 64;
+
+    std::size_t  m_dimension;
+    std::size_t  m_pairCount;
+    double       m_sigma;
+    double       m_learningRate;
+    double       m_weightDecay{0.005};
+    std::size_t  m_noiseTableSize;
+    uint64_t     m_seed;
+    std::size_t  m_generation{0};
+    std::size_t  m_threadCount;
+
+    NoiseTable   m_noiseTable;
+    std::vector<double>  m_mean;
+    std::vector<double>  m_firstMoment;
+    std::vector<double>  m_secondMoment;
+    std::vector<PairResult>  m_results;
+
+    std::vector<double>  m_bestSolution;
+    double               m_bestFitness{-std::numeric_limits<double>::max()};
+
+    std::unique_ptr<ThreadPool>  m_threadPool;
+    std::function<double(std::span<const double> value)>   m_fitnessFunc;
+};
+
+} // namespace es
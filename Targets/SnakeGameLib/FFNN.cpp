@@ -10,6 +10,7 @@
 
 // Project includes
 #include "FFNN.hpp"
+#include "Kernels.hpp"
 // External includes
 // System includes
 #include <algorithm>
@@ -56,20 +57,35 @@ void FFNN::Init(const std::vector<int> & layers, const std::vector<ActivationTyp
         // Create activation object per hidden layer and the output later (the last layer).
         m_activations.emplace_back(ActivationFactory::Create(activations[i]));
     }
+
+    PackWeights();
 }
 
 
 Eigen::MatrixXd FFNN::Forward(const Eigen::MatrixXd & input)
 {
-    Eigen::MatrixXd H = input;
+    using RowMajorMatrixXd = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+    const auto & kernels = kernels::GetKernels();
+
+    // Each input row is a separate sample. Biases are added to every row.
+    RowMajorMatrixXd H = input;
+    RowMajorMatrixXd next;
     for (size_t i=0; i<m_weights.size(); ++i)
     {
-        H = H * m_weights[i] + m_biases[i];
+        auto rows = static_cast<std::size_t>(H.rows());
+        auto inputSize  = static_cast<std::size_t>(m_weights[i].rows());
+        auto outputSize = static_cast<std::size_t>(m_weights[i].cols());
+
+        next.resize(H.rows(), m_weights[i].cols());
+        kernels.denseForward(H.data(), rows, inputSize, m_packedWeights[i].data(), m_biases[i].data(), outputSize,
+                             next.data());
         // Apply activation.
-        H = m_activations[i]->Calculate(H);
+        m_activations[i]->Calculate(next.data(), rows, outputSize);
+        H.swap(next);
     }
 
-    return H ;
+    return H;
 }
 
 
@@ -79,9 +95,11 @@ std::vector<double> FFNN::SerializeWeights()
 }
 
 
-bool FFNN::DeserializeWeights(const std::vector<double> & weightsVector)
+bool FFNN::DeserializeWeights(std::span<const double> weightsVector)
 {
-    return DeserializeMatrices(weightsVector, m_weights);
+    bool result = DeserializeMatrices(weightsVector, m_weights);
+    PackWeights();
+    return result;
 }
 
 
@@ -91,7 +109,7 @@ std::vector<double> FFNN::SerializeBiases()
 }
 
 
-bool FFNN::DeserializeBiases(const std::vector<double> & biasesVector)
+bool FFNN::DeserializeBiases(std::span<const double> biasesVector)
 {
     return DeserializeMatrices(biasesVector, m_biases);
 }
@@ -110,18 +128,21 @@ std::vector<double> FFNN::SerializeAllParameters()
 }
 
 
-bool FFNN::DeserializeAllParameters(const std::vector<double> & vector)
+bool FFNN::DeserializeAllParameters(std::span<const double> vector)
 {
     // Get the size of weights vector. The rest of them will be biases.
     std::size_t totalMatricesSize = 0;
     for (const auto & matrix : m_weights)
         totalMatricesSize += matrix.size();
 
-    // Split the vector into two parts: weights and biases.
-    std::vector<double>  weightsVec(vector.begin(), vector.begin() + totalMatricesSize);
-    std::vector<double>  biasesVec(vector.begin() + totalMatricesSize, vector.end());
+    if (vector.size() < totalMatricesSize)
+    {
+        return false;
+    }
 
-    return DeserializeWeights(weightsVec) && DeserializeBiases(biasesVec);
+    // Split the vector into two parts: weights and biases.
+    return DeserializeWeights(vector.first(totalMatricesSize)) &&
+           DeserializeBiases(vector.subspan(totalMatricesSize));
 }
 
 
@@ -246,6 +267,8 @@ bool FFNN::Load(const std::string & filename)
         ReadMatrix(bias);
     }
 
+    PackWeights();
+
     return true;
 }
 
@@ -266,6 +289,38 @@ void FFNN::PrintAll()
 }
 
 
+std::vector<int> FFNN::GetLayers() const
+{
+    std::vector<int>  layers;
+
+    if (m_weights.empty())
+    {
+        return layers;
+    }
+
+    layers.emplace_back(static_cast<int>(m_weights.front().rows()));
+    for (const auto & weight : m_weights)
+    {
+        layers.emplace_back(static_cast<int>(weight.cols()));
+    }
+
+    return layers;
+}
+
+
+std::vector<ActivationType> FFNN::GetActivationTypes() const
+{
+    std::vector<ActivationType>  activations;
+
+    for (const auto activation : m_activations)
+    {
+        activations.emplace_back(activation->GetType());
+    }
+
+    return activations;
+}
+
+
 std::vector<double> FFNN::SerializeMatrices(const std::vector<Eigen::MatrixXd> & matrices)
 {
     std::vector<double>  resultVec;
@@ -281,7 +336,7 @@ std::vector<double> FFNN::SerializeMatrices(const std::vector<Eigen::MatrixXd> &
 }
 
 
-bool FFNN::DeserializeMatrices(const std::vector<double> & vector, std::vector<Eigen::MatrixXd> & matrices)
+bool FFNN::DeserializeMatrices(std::span<const double> vector, std::vector<Eigen::MatrixXd> & matrices)
 {
     size_t totalSize = 0;
     for (const auto & matrix : matrices)
@@ -305,6 +360,20 @@ bool FFNN::DeserializeMatrices(const std::vector<double> & vector, std::vector<E
 }
 
 
+void FFNN::PackWeights()
+{
+    using RowMajorMatrixXd = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+    m_packedWeights.resize(m_weights.size());
+    for (std::size_t i=0; i<m_weights.size(); ++i)
+    {
+        const auto & weight = m_weights[i];
+        m_packedWeights[i].resize(weight.size());
+        Eigen::Map<RowMajorMatrixXd>(m_packedWeights[i].data(), weight.rows(), weight.cols()) = weight;
+    }
+}
+
+
 void FFNN::DeleteActivations()
 {
     for (auto activation : m_activations)
@@ -321,29 +390,68 @@ Eigen::MatrixXd Sigmoid::Calculate(Eigen::MatrixXd & mat)
 }
 
 
+void Sigmoid::Calculate(double * data, std::size_t rows, std::size_t cols)
+{
+    kernels::GetKernels().sigmoid(data, rows * cols);
+}
+
+
 Eigen::MatrixXd Tanh::Calculate(Eigen::MatrixXd & mat)
 {
     return mat.unaryExpr([&](double x) { return (std::exp(x) - std::exp(-x)) / (std::exp(x) + std::exp(-x)); });
 }
 
 
+void Tanh::Calculate(double * data, std::size_t rows, std::size_t cols)
+{
+    kernels::GetKernels().tanh(data, rows * cols);
+}
+
+
 Eigen::MatrixXd ReLU::Calculate(Eigen::MatrixXd & mat)
 {
     return mat.unaryExpr([&](double x) { return std::max<double>(x, 0); });
 }
 
 
+void ReLU::Calculate(double * data, std::size_t rows, std::size_t cols)
+{
+    kernels::GetKernels().relu(data, rows * cols);
+}
+
+
 Eigen::MatrixXd LeakyReLU::Calculate(Eigen::MatrixXd & mat)
 {
     return mat.unaryExpr([&](double x) { return x > 0 ? x : x * 0.001; });
 }
 
 
+void LeakyReLU::Calculate(double * data, std::size_t rows, std::size_t cols)
+{
+    kernels::GetKernels().leakyRelu(data, rows * cols);
+}
+
+
 Eigen::MatrixXd Softmax::Calculate(Eigen::MatrixXd & mat)
 {
-    double sumExp = 0;
-    mat = mat.unaryExpr([&](double x) { sumExp += std::exp(x); return x; });
-    return mat.unaryExpr([&](double x) { return std::exp(x) / sumExp; });
+    // Each row is a separate sample and normalized independently.
+    Eigen::MatrixXd result = mat.unaryExpr([&](double x) { return std::exp(x); });
+    for (Eigen::Index r=0; r<result.rows(); ++r)
+    {
+        double sumExp = 0;
+        for (Eigen::Index c=0; c<result.cols(); ++c)
+        {
+            sumExp += result(r, c);
+        }
+        result.row(r) /= sumExp;
+    }
+    return result;
+}
+
+
+void Softmax::Calculate(double * data, std::size_t rows, std::size_t cols)
+{
+    kernels::GetKernels().softmax(data, rows, cols);
 }
 
 
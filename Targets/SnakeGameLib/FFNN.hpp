@@ -14,6 +14,7 @@
 #include <Eigen/Dense>
 // System includes
 #include <random>
+#include <span>
 
 
 // Activation Type
@@ -37,8 +38,11 @@ public:
 
     virtual Eigen::MatrixXd Calculate(Eigen::MatrixXd & mat) = 0;
 
+    // Applies the activation in-place on a row-major matrix by using the kernels selected for the CPU.
+    virtual void Calculate(double * data, std::size_t rows, std::size_t cols) = 0;
+
     // Returns activation type
-    ActivationType GetType() { return m_type; }
+    ActivationType GetType() const { return m_type; }
 
 protected:
     ActivationType  m_type{ActivationType::kActivationTypeInvalid};
@@ -61,26 +65,26 @@ public:
     // Initializes layers.
     void Init(const std::vector<int> & layers, const std::vector<ActivationType> & activations);
 
-    // Makes prediction by using input data.
+    // Makes prediction by using input data. Each row of the input is predicted separately.
     Eigen::MatrixXd Forward(const Eigen::MatrixXd & input);
 
     // Returns all weights as a single vector.
     std::vector<double> SerializeWeights();
 
     // Sets all weights from a vector.
-    bool DeserializeWeights(const std::vector<double> & weightsVector);
+    bool DeserializeWeights(std::span<const double> weightsVector);
 
     // Returns all biases as a single vector.
     std::vector<double> SerializeBiases();
 
     // Sets all biases from a vector.
-    bool DeserializeBiases(const std::vector<double> & biasesVector);
+    bool DeserializeBiases(std::span<const double> biasesVector);
 
     // Returns all parameters, weights + biases, as a single vector.
     std::vector<double> SerializeAllParameters();
 
     // Sets all parameters, weights + biases, from a vector.
-    bool DeserializeAllParameters(const std::vector<double> & vector);
+    bool DeserializeAllParameters(std::span<const double> vector);
 
     // Save the network into a file.
     bool Save(const std::string & filename);
@@ -91,19 +95,35 @@ public:
     // Prints all interval variables and states.
     void PrintAll();
 
+    // Returns layer sizes including the input layer.
+    std::vector<int> GetLayers() const;
+
+    // Returns activation types of all hidden layers + output layer.
+    std::vector<ActivationType> GetActivationTypes() const;
+
+    // Returns weight matrices. Each matrix is (input size x output size) of its layer.
+    const std::vector<Eigen::MatrixXd> & GetWeights() const { return m_weights; }
+
+    // Returns bias matrices. Each matrix is (1 x output size) of its layer.
+    const std::vector<Eigen::MatrixXd> & GetBiases() const { return m_biases; }
+
 private:
     // Serialize all matrices into a single vector.
     std::vector<double> SerializeMatrices(const std::vector<Eigen::MatrixXd> & matrices);
 
     // Deserialize a vector into source matrices.
-    bool DeserializeMatrices(const std::vector<double> & vector, std::vector<Eigen::MatrixXd> & matrices);
+    bool DeserializeMatrices(std::span<const double> vector, std::vector<Eigen::MatrixXd> & matrices);
 
     // Deletes all activations.
     void DeleteActivations();
 
+    // Updates row-major copies of weights used by the kernels. Must be called after weights are changed.
+    void PackWeights();
+
 private:
     std::vector<Eigen::MatrixXd>  m_weights;
     std::vector<Eigen::MatrixXd>  m_biases;
+    std::vector<std::vector<double>>  m_packedWeights;
     std::vector<ActivationBase*>  m_activations;
     std::mt19937                  m_rndEngine;
 };
@@ -116,6 +136,7 @@ class Sigmoid : public ActivationBase
 public:
     Sigmoid() { m_type = ActivationType::kActivationTypeSigmoid; }
     Eigen::MatrixXd Calculate(Eigen::MatrixXd & mat) final;
+    void Calculate(double * data, std::size_t rows, std::size_t cols) final;
 };
 
 
@@ -124,6 +145,7 @@ class Tanh : public ActivationBase
 public:
     Tanh() { m_type = ActivationType::kActivationTypeTanh; }
     Eigen::MatrixXd Calculate(Eigen::MatrixXd & mat) final;
+    void Calculate(double * data, std::size_t rows, std::size_t cols) final;
 };
 
 
@@ -132,6 +154,7 @@ class ReLU : public ActivationBase
 public:
     ReLU() { m_type = ActivationType::kActivationTypeReLU; }
     Eigen::MatrixXd Calculate(Eigen::MatrixXd & mat) final;
+    void Calculate(double * data, std::size_t rows, std::size_t cols) final;
 };
 
 
@@ -140,6 +163,7 @@ class LeakyReLU : public ActivationBase
 public:
     LeakyReLU() { m_type = ActivationType::kActivationTypeLeakyReLU; }
     Eigen::MatrixXd Calculate(Eigen::MatrixXd & mat) final;
+    void Calculate(double * data, std::size_t rows, std::size_t cols) final;
 };
 
 
@@ -148,6 +172,7 @@ class Softmax : public ActivationBase
 public:
     Softmax() { m_type = ActivationType::kActivationTypeSoftmax; }
     Eigen::MatrixXd Calculate(Eigen::MatrixXd & mat) final;
+    void Calculate(double * data, std::size_t rows, std::size_t cols) final;
 };
 
 
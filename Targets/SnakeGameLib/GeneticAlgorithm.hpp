@@ -10,41 +10,118 @@
 #pragma once
 
 // Project includes
+#include <Kernels.hpp>
+#include <PerfCounters.hpp>
+#include <RandomStream.hpp>
 #include <ThreadPool.hpp>
+#include <Trace.hpp>
 // External includes
 // System includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
 #include <future>
+#include <new>
+#include <numeric>
+#include <ostream>
+#include <queue>
+#include <random>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 
 namespace ga
 {
 
-template<typename T>
-class Individual
+// Allocates memory aligned to the given boundary. Used to align genomes to cache lines.
+template<typename T, std::size_t Alignment>
+class AlignedAllocator
 {
 public:
-    Individual() : m_fitness(0)
+    using value_type = T;
+
+    template<typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    explicit AlignedAllocator(const AlignedAllocator<U, Alignment> &)
     {
     }
 
-    explicit Individual(std::vector<T> value) : m_value{std::move(value)}, m_fitness(0)
+    T * allocate(std::size_t n)
     {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{Alignment}));
     }
 
-    std::vector<T> GetValue() const
+    void deallocate(T * p, std::size_t)
     {
-        return m_value;
+        ::operator delete(p, std::align_val_t{Alignment});
     }
 
-    double GetFitness() const
+    bool operator==(const AlignedAllocator &) const { return true; }
+    bool operator!=(const AlignedAllocator &) const { return false; }
+};
+
+
+// Fitness cache policies. Fitness values of the previous generation are reused for identical genomes.
+enum class FitnessCachePolicy : int32_t
+{
+    kFitnessCachePolicyOff  = 0,    // Every individual is evaluated.
+    kFitnessCachePolicyOn   = 1,    // Identical genomes are evaluated once.
+    kFitnessCachePolicyReevaluateElites = 2,  // Same as on, but transferred individuals are evaluated again. For noisy
+                                              // fitness functions.
+};
+
+
+// Wall-clock time (seconds) of the phases of the last generation.
+struct GenerationTimes
+{
+    double  breed{0};       // Creating children, or random individuals of the initial generation.
+    double  evaluate{0};    // Calculating fitness values.
+    double  rank{0};        // Ranking individuals by fitness.
+};
+
+
+// Migration topologies of the island model.
+enum class MigrationTopology : int32_t
+{
+    kMigrationTopologyRing      = 0,    // Each island sends its migrants to the next island.
+    kMigrationTopologyAllToAll  = 1,    // Each island sends its migrants to all other islands.
+};
+
+
+// A read-only view of an individual in a population.
+template<typename T>
+class Individual
+{
+public:
+    Individual(std::span<const T> value, double fitness) : m_value{value}, m_fitness(fitness)
     {
-        return m_fitness;
     }
 
-    void SetFitness(double fitness)
+    std::span<const T> GetValue() const
+    {
+        return m_value;
+    }
+
+    double GetFitness() const
     {
-        m_fitness = fitness;
+        return m_fitness;
     }
 
     auto operator[](const std::size_t i) const
@@ -53,11 +130,15 @@ public:
     }
 
 private:
-    std::vector<T>  m_value;
-    double          m_fitness;
+    std::span<const T>  m_value;
+    double              m_fitness;
 };
 
 
+// Population keeps all genomes in a single (population size x genetic material length) matrix. The next generation
+// is bred into a second matrix and the two are swapped, so no genome is copied except the transferred ones.
+// All random numbers come from streams keyed by (seed, generation, individual, gene). Results don't depend on the
+// number of threads or on the order the tasks run.
 template<typename T>
 class Population
 {
@@ -73,28 +154,59 @@ public:
         m_transferCount = (transferRatio * maxPopulation) / 100;
         m_crossoverThreshold = (crossover * maxPopulation) / 100;
         m_newIndividualsPerGeneration = maxPopulation - m_transferCount;
+        m_rankedCount = std::min(maxPopulation, std::max({m_crossoverThreshold, m_transferCount, std::size_t(1)}));
+
+        // Each genome starts at a cache line boundary.
+        constexpr std::size_t itemsPerLine = kAlignment % sizeof(T) == 0 ? kAlignment / sizeof(T) : 1;
+        m_genomeStride = (geneticMaterialLength + itemsPerLine - 1) / itemsPerLine * itemsPerLine;
 
         std::random_device  rndDev;
-        m_rndEngine.seed(rndDev());
+        m_seed = (static_cast<uint64_t>(rndDev()) << 32) | rndDev();
+        m_threadCount = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    ~Population()
+    {
+        StopSteadyState();
+    }
+
+    // Sets the seed of all random number streams. Must be called before creating the initial generation.
+    void SetSeed(uint64_t seed)
+    {
+        m_seed = seed;
+    }
+
+    // Sets the number of threads of the population and the CPUs they run on. All CPUs are used if cpus is empty.
+    // Must be called before creating the initial generation.
+    void SetThreads(std::size_t threadCount, const std::vector<int> & cpus)
+    {
+        m_threadCount = std::max<std::size_t>(threadCount, 1);
+        m_cpus = cpus;
     }
 
     void CreateInitialGeneration()
     {
-        // Create thread pool to calculate fitness functions.
-        ThreadPool  tp(std::thread::hardware_concurrency());
-        m_population.resize(m_maxPopulation);
+        Allocate();
+        m_generation = 0;
+
+        auto startTime = Clock::now();
+        auto & tp = *m_threadPool;
 
         std::vector<std::future<void>>  results;
         for (std::size_t i=0; i<m_maxPopulation; ++i)
         {
             auto futureRet = tp.Enqueue([&](std::size_t i)
             {
-                // Generate random generic material value.
-                std::vector<T>  value(m_geneticMaterialLength, 0);
-                std::generate_n(value.begin(), m_geneticMaterialLength, m_randomItemFunc);
+                PerfScope  perfScope(PerfRegion::kPerfRegionBreed);
 
-                Individual<T> newChild{value};
-                m_population[i] = newChild;
+                // Generate random generic material value.
+                auto genome = GetGenome(m_genomes, i);
+                for (std::size_t g=0; g<m_geneticMaterialLength; ++g)
+                {
+                    RandomStream  geneRng(m_seed, m_generation, i, kFirstGeneStream + g);
+                    genome[g] = m_randomItemFunc(geneRng);
+                }
+                m_hashes[i] = HashGenome(genome);
             }, i);
 
             results.emplace_back(std::move(futureRet));
@@ -107,33 +219,44 @@ public:
             results[i].get();     // We don't have a return value but this will rethrow an uncaught exception.
         }
 
-        CalculatePopulationFitnessValues();
+        auto breedTime = Clock::now();
+        CalculatePopulationFitnessValues({}, 0);
+
+        auto evaluateTime = Clock::now();
+        RankIndividuals();
 
-        SortIndividuals();
+        SetGenerationTimes(startTime, breedTime, evaluateTime);
     }
 
     void CreateNextGeneration()
     {
-        std::vector<Individual<T>>  nextGeneration;
-        nextGeneration.resize(m_maxPopulation);
+        m_generation++;
 
-        // Create thread pool to calculate fitness functions.
-        ThreadPool  tp(std::thread::hardware_concurrency());
+        auto startTime = Clock::now();
+        auto & tp = *m_threadPool;
 
         std::vector<std::future<void>>  results;
         for (std::size_t i=0; i<m_maxPopulation; ++i)
         {
             auto futureRet = tp.Enqueue([&](std::size_t i)
             {
+                PerfScope  perfScope(PerfRegion::kPerfRegionBreed);
+                auto child = GetGenome(m_nextGenomes, i);
+
                 if (i < m_transferCount)
                 {
-                    nextGeneration[i] = m_population[i];
+                    auto elite = GetGenome(m_genomes, m_ranking[i]);
+                    std::copy(elite.begin(), elite.end(), child.begin());
+                    m_nextHashes[i] = m_hashes[m_ranking[i]];
                 }
                 else
                 {
-                    Individual<T> & mother = m_population[GetRandomNumber(0, m_crossoverThreshold)];
-                    Individual<T> & father = m_population[GetRandomNumber(0, m_crossoverThreshold)];
-                    nextGeneration[i] = CreateChild(mother, father, m_parentRatio, m_mutateProbability);
+                    RandomStream  rng(m_seed, m_generation, i, kParentStream);
+                    std::size_t parentCount = std::max<std::size_t>(m_crossoverThreshold, 1);
+                    auto mother = GetGenome(m_genomes, m_ranking[rng.UniformIndex(parentCount)]);
+                    auto father = GetGenome(m_genomes, m_ranking[rng.UniformIndex(parentCount)]);
+                    CreateChild(mother, father, child, m_generation, i, m_parentRatio, m_mutateProbability);
+                    m_nextHashes[i] = HashGenome(child);
                 }
             }, i);
 
@@ -147,111 +270,916 @@ public:
             results[i].get();     // We don't have a return value but this will rethrow an uncaught exception.
         }
 
-        m_population = nextGeneration;
+        // Fitness values of the previous generation by genome hash.
+        std::unordered_map<uint64_t, double>  knownFitness;
+        if (m_fitnessCachePolicy != FitnessCachePolicy::kFitnessCachePolicyOff)
+        {
+            knownFitness.reserve(m_maxPopulation);
+            for (std::size_t i=0; i<m_maxPopulation; ++i)
+            {
+                knownFitness.emplace(m_hashes[i], m_fitness[i]);
+            }
+        }
+
+        // The next generation becomes the current one. The old buffer is reused for the next breeding.
+        m_genomes.swap(m_nextGenomes);
+        m_hashes.swap(m_nextHashes);
+
+        auto breedTime = Clock::now();
+        CalculatePopulationFitnessValues(knownFitness, m_transferCount);
+
+        auto evaluateTime = Clock::now();
+        RankIndividuals();
+
+        SetGenerationTimes(startTime, breedTime, evaluateTime);
+    }
+
+    // Evolves the population without generations. Births run continuously on the threads of the population: each
+    // birth picks two parents among the best individuals, breeds a child, evaluates it and replaces the worst
+    // individual if the child is better. Births never wait for each other, not even between calls, so slow
+    // evaluations don't leave threads idle. The call returns when birthCount more births are finished and publishes
+    // the population as the current generation while births go on. Every population size births count as a
+    // generation. The result depends on the timing of the threads and is not reproducible.
+    void EvolveSteadyState(std::size_t birthCount)
+    {
+        // Births are bred and evaluated together, so their whole time counts as evaluation.
+        auto startTime = Clock::now();
+
+        {
+            std::unique_lock<std::mutex>  lock(m_steadySync);
+            if (!m_steadyRunning)
+            {
+                StartSteadyState();
+            }
+
+            m_steadyTarget += birthCount;
+            m_steadySignal.wait(lock, [&]() { return m_finishedBirths >= m_steadyTarget || m_steadyError; });
+            if (m_steadyError)
+            {
+                auto error = m_steadyError;
+                lock.unlock();
+                StopSteadyState();
+                std::rethrow_exception(error);
+            }
+
+            m_evaluationCount = m_finishedBirths - m_publishedBirths;
+            m_publishedBirths = m_finishedBirths;
+            PublishSteadyState();
+        }
+
+        m_generation += static_cast<uint32_t>((birthCount + m_maxPopulation - 1) / m_maxPopulation);
 
-        CalculatePopulationFitnessValues();
+        auto evaluateTime = Clock::now();
+        RankIndividuals();
 
-        SortIndividuals();
+        SetGenerationTimes(startTime, startTime, evaluateTime);
     }
 
-    void SetFitnessFunc(std::function<std::size_t(const std::vector<T> & value)>&& func)
+    void SetFitnessFunc(std::function<double(std::span<const T> value)>&& func)
     {
         m_fitnessFunc = std::move(func);
     }
 
-    void SetRandomItemFunc(std::function<T()> && func)
+    // Sets a fitness function that evaluates a batch of individuals at once and returns their fitness values in the
+    // same order. When set, the population is split into batches of at most maxBatchSize individuals.
+    void SetBatchFitnessFunc(std::function<std::vector<double>(const std::vector<std::span<const T>> & values)>&& func,
+                             std::size_t maxBatchSize)
+    {
+        m_batchFitnessFunc = std::move(func);
+        m_maxBatchSize = std::max<std::size_t>(maxBatchSize, 1);
+    }
+
+    // Sets a fitness function that evaluates all individuals of a generation at once on the given thread pool, so
+    // that it can compare individuals while evaluating them. When set, it's used instead of the other fitness
+    // functions, except in steady-state evolution.
+    void SetPopulationFitnessFunc(std::function<std::vector<double>(const std::vector<std::span<const T>> & values,
+                                                                    ThreadPool & threadPool)>&& func)
+    {
+        m_populationFitnessFunc = std::move(func);
+    }
+
+    void SetFitnessCachePolicy(FitnessCachePolicy policy)
+    {
+        m_fitnessCachePolicy = policy;
+    }
+
+    // Returns the number of fitness evaluations of the last generation. Cached individuals are not counted.
+    std::size_t GetEvaluationCount() const
+    {
+        return m_evaluationCount;
+    }
+
+    // Returns the time spent in each phase of the last generation.
+    const GenerationTimes & GetGenerationTimes() const
+    {
+        return m_generationTimes;
+    }
+
+    // Returns fitness values of the current generation in the order of the individuals.
+    const std::vector<double> & GetFitnessValues() const
+    {
+        return m_fitness;
+    }
+
+    // Returns the number of threads of the population.
+    std::size_t GetThreadCount() const
+    {
+        return m_threadPool ? m_threadPool->GetThreadCount() : 0;
+    }
+
+    // Returns total time (seconds) the threads of the population have spent running tasks.
+    double GetThreadBusyTime() const
+    {
+        return m_threadPool ? m_threadPool->GetBusyTime() : 0;
+    }
+
+    // Sets the function that generates a random gene. It must draw random numbers only from the given stream.
+    void SetRandomItemFunc(std::function<T(RandomStream & rng)> && func)
     {
         m_randomItemFunc = std::move(func);
     }
 
+    // Replaces the worst individuals of the current generation with the given individuals and ranks the population
+    // again. Fitness values of the immigrants are not recalculated. While steady-state births are running, immigrants
+    // enter the population like children and are dropped if they are not better than the worst individual.
+    void Immigrate(const std::vector<std::vector<T>> & genomes, const std::vector<double> & fitness)
+    {
+        if (m_steadyRunning)
+        {
+            {
+                std::lock_guard<std::mutex>  lock(m_steadySync);
+                for (std::size_t i=0; i<genomes.size(); ++i)
+                {
+                    ReplaceWorstLive(genomes[i], fitness[i]);
+                }
+                PublishSteadyState();
+            }
+
+            RankIndividuals();
+            return;
+        }
+
+        auto IsWorse = [&](std::size_t left, std::size_t right)
+        {
+            return m_fitness[left] < m_fitness[right] || (m_fitness[left] == m_fitness[right] && left > right);
+        };
+
+        std::vector<std::size_t>  worst(m_maxPopulation);
+        std::iota(worst.begin(), worst.end(), 0);
+        std::size_t count = std::min(genomes.size(), m_maxPopulation);
+        SelectTop(worst.begin(), worst.end(), count, IsWorse);
+
+        for (std::size_t i=0; i<count; ++i)
+        {
+            auto genome = GetGenome(m_genomes, worst[i]);
+            std::copy(genomes[i].begin(), genomes[i].end(), genome.begin());
+            m_fitness[worst[i]] = fitness[i];
+            m_hashes[worst[i]] = HashGenome(genome);
+        }
+
+        RankIndividuals();
+    }
+
+    // Writes the current generation to the stream. Genome hashes and the ranking are not written since they are
+    // derived from the genomes and the fitness values. Random streams have no state other than the seed and the
+    // generation.
+    void Save(std::ostream & stream) const
+    {
+        auto WriteUInt64 = [&](uint64_t val) { stream.write(reinterpret_cast<const char*>(&val), sizeof(val)); };
+
+        WriteUInt64(m_maxPopulation);
+        WriteUInt64(m_geneticMaterialLength);
+        WriteUInt64(m_seed);
+        WriteUInt64(m_generation);
+
+        for (std::size_t i=0; i<m_maxPopulation; ++i)
+        {
+            auto genome = GetGenome(m_genomes, i);
+            stream.write(reinterpret_cast<const char*>(genome.data()), static_cast<std::streamsize>(genome.size_bytes()));
+        }
+        stream.write(reinterpret_cast<const char*>(m_fitness.data()),
+                     static_cast<std::streamsize>(m_fitness.size() * sizeof(double)));
+    }
+
+    // Reads a generation written by Save(). The population must be created with the same parameters.
+    // Returns false if the stream is not compatible or can't be read.
+    bool Load(std::istream & stream)
+    {
+        auto ReadUInt64 = [&]() { uint64_t val{0}; stream.read(reinterpret_cast<char*>(&val), sizeof(val)); return val; };
+
+        if (ReadUInt64() != m_maxPopulation || ReadUInt64() != m_geneticMaterialLength)
+        {
+            return false;
+        }
+        m_seed = ReadUInt64();
+        m_generation = static_cast<uint32_t>(ReadUInt64());
+
+        Allocate();
+
+        for (std::size_t i=0; i<m_maxPopulation; ++i)
+        {
+            auto genome = GetGenome(m_genomes, i);
+            stream.read(reinterpret_cast<char*>(genome.data()), static_cast<std::streamsize>(genome.size_bytes()));
+            m_hashes[i] = HashGenome(genome);
+        }
+        stream.read(reinterpret_cast<char*>(m_fitness.data()),
+                    static_cast<std::streamsize>(m_fitness.size() * sizeof(double)));
+
+        if (!stream)
+        {
+            return false;
+        }
+
+        RankIndividuals();
+        return true;
+    }
+
+    // Returns the number of individuals.
+    std::size_t GetSize() const
+    {
+        return m_maxPopulation;
+    }
+
+    // Returns the number of ranked individuals.
+    std::size_t GetRankedCount() const
+    {
+        return m_rankedCount;
+    }
+
     // Returns the best individual of the current population.
-    const Individual<T> & GetBestIndividual() const
+    Individual<T> GetBestIndividual() const
     {
-        return m_population.front();
+        return GetIndividual(0);
+    }
+
+    // Returns the individual at the given rank of the current population. The best individual is at rank 0.
+    // Only the first GetRankedCount() ranks are available.
+    Individual<T> GetIndividual(std::size_t rank) const
+    {
+        auto index = m_ranking[rank];
+        return Individual<T>{GetGenome(m_genomes, index), m_fitness[index]};
     }
 
 private:
-    Individual<T> CreateChild(const Individual<T> & mother, const Individual<T> & father, const std::size_t parentRatio,
-                              const std::size_t mutateProbability)
+    using GenomeBuffer = std::vector<T, AlignedAllocator<T, 64>>;
+    using Clock = std::chrono::steady_clock;
+
+    // Sets the phase times of the last generation from the time points at the end of each phase.
+    void SetGenerationTimes(Clock::time_point start, Clock::time_point breedEnd, Clock::time_point evaluateEnd)
+    {
+        auto end = Clock::now();
+        m_generationTimes.breed    = std::chrono::duration<double>(breedEnd - start).count();
+        m_generationTimes.evaluate = std::chrono::duration<double>(evaluateEnd - breedEnd).count();
+        m_generationTimes.rank     = std::chrono::duration<double>(end - evaluateEnd).count();
+
+        if (Tracer::IsEnabled())
+        {
+            if (breedEnd != start)
+            {
+                Tracer::Record("Breed", Tracer::ToTraceTime(start), Tracer::ToTraceTime(breedEnd));
+            }
+            Tracer::Record("Evaluate", Tracer::ToTraceTime(breedEnd), Tracer::ToTraceTime(evaluateEnd));
+            Tracer::Record("Rank", Tracer::ToTraceTime(evaluateEnd), Tracer::ToTraceTime(end));
+        }
+    }
+
+    // Allocates the buffers and the thread pool of the population.
+    void Allocate()
+    {
+        StopSteadyState();
+
+        m_genomes.assign(m_maxPopulation * m_genomeStride, T{});
+        m_nextGenomes.assign(m_maxPopulation * m_genomeStride, T{});
+        m_fitness.assign(m_maxPopulation, 0);
+        m_hashes.assign(m_maxPopulation, 0);
+        m_nextHashes.assign(m_maxPopulation, 0);
+        m_ranking.resize(m_maxPopulation);
+        m_threadPool = std::make_unique<ThreadPool>(m_threadCount, m_cpus);
+    }
+
+    // Starts steady-state births from the current generation. Must be called with m_steadySync locked.
+    void StartSteadyState()
     {
-        std::vector<T>  childValue(m_geneticMaterialLength, 0);
+        // Births work on their own copy of the population. The current generation is only updated when published.
+        std::copy(m_genomes.begin(), m_genomes.end(), m_nextGenomes.begin());
+        m_nextHashes = m_hashes;
+        m_liveFitness = m_fitness;
+        m_parentPins.assign(m_maxPopulation, 0);
 
-        for (size_t i=0; i < m_geneticMaterialLength; ++i)
+        auto IsBetter = [&](std::size_t left, std::size_t right) { return IsLiveBetter(left, right); };
+
+        // The best individuals are the parents, the rest are candidates for replacement.
+        std::vector<std::size_t>  order(m_maxPopulation);
+        std::iota(order.begin(), order.end(), 0);
+        std::size_t parentCount = std::min(std::max<std::size_t>(m_crossoverThreshold, 1), m_maxPopulation);
+        SelectTop(order.begin(), order.end(), parentCount, IsBetter);
+
+        m_parentHeap.assign(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(parentCount));
+        m_restHeap.assign(order.begin() + static_cast<std::ptrdiff_t>(parentCount), order.end());
+        std::make_heap(m_parentHeap.begin(), m_parentHeap.end(), IsBetter);
+        std::make_heap(m_restHeap.begin(), m_restHeap.end(), IsBetter);
+
+        m_steadyFirstGeneration = m_generation;
+        m_startedBirths = 0;
+        m_finishedBirths = 0;
+        m_publishedBirths = 0;
+        m_steadyTarget = 0;
+        m_steadyStop = false;
+        m_steadyError = nullptr;
+        m_steadyRunning = true;
+
+        // Each task runs a birth and enqueues the next one, so every thread always has a birth to run.
+        for (std::size_t t=0; t<m_threadCount; ++t)
+        {
+            ++m_birthsInFlight;
+            m_threadPool->Enqueue([this]() { RunBirth(); });
+        }
+    }
+
+    // Stops steady-state births and waits until the running ones are finished. The current generation keeps the
+    // last published state.
+    void StopSteadyState()
+    {
+        std::unique_lock<std::mutex>  lock(m_steadySync);
+        if (!m_steadyRunning)
+        {
+            return;
+        }
+
+        m_steadyStop = true;
+        m_steadySignal.wait(lock, [&]() { return m_birthsInFlight == 0; });
+        m_steadyRunning = false;
+    }
+
+    // Runs a steady-state birth and enqueues the next one unless births are stopped.
+    void RunBirth()
+    {
+        thread_local std::vector<T>  child;
+        child.resize(m_geneticMaterialLength);
+
+        uint32_t     generation;
+        std::size_t  individual;
+        std::size_t  mother;
+        std::size_t  father;
         {
-            if (GetRandomNumber(0, 100) < mutateProbability)
+            std::lock_guard<std::mutex>  lock(m_steadySync);
+            if (m_steadyStop)
             {
-                childValue[i] = m_randomItemFunc();
+                --m_birthsInFlight;
+                m_steadySignal.notify_all();
+                return;
             }
-            else if (GetRandomNumber(0, 100) < parentRatio)
+
+            // Births are numbered like individuals of the following generations.
+            std::size_t birth = m_startedBirths++;
+            generation = static_cast<uint32_t>(m_steadyFirstGeneration + 1 + birth / m_maxPopulation);
+            individual = birth % m_maxPopulation;
+
+            // Parents are pinned so that no other birth replaces them while the child is bred.
+            RandomStream  rng(m_seed, generation, individual, kParentStream);
+            mother = m_parentHeap[rng.UniformIndex(m_parentHeap.size())];
+            father = m_parentHeap[rng.UniformIndex(m_parentHeap.size())];
+            ++m_parentPins[mother];
+            ++m_parentPins[father];
+        }
+
+        bool pinned = true;
+        try
+        {
             {
-                childValue[i] = mother[i];
+                PerfScope  perfScope(PerfRegion::kPerfRegionBreed);
+                CreateChild(GetGenome(m_nextGenomes, mother), GetGenome(m_nextGenomes, father), child, generation,
+                            individual, m_parentRatio, m_mutateProbability);
             }
-            else
+
+            {
+                std::lock_guard<std::mutex>  lock(m_steadySync);
+                --m_parentPins[mother];
+                --m_parentPins[father];
+                pinned = false;
+            }
+
+            double fitness = m_fitnessFunc ? m_fitnessFunc(child) : m_batchFitnessFunc({std::span<const T>(child)}).front();
+
+            std::lock_guard<std::mutex>  lock(m_steadySync);
+            ReplaceWorstLive(child, fitness);
+
+            if (++m_finishedBirths >= m_steadyTarget)
             {
-                childValue[i] = father[i];
+                m_steadySignal.notify_all();
+            }
+
+            if (!m_steadyStop)
+            {
+                m_threadPool->Enqueue([this]() { RunBirth(); });
+                return;
             }
         }
+        catch (...)
+        {
+            std::lock_guard<std::mutex>  lock(m_steadySync);
+            if (pinned)
+            {
+                --m_parentPins[mother];
+                --m_parentPins[father];
+            }
+            if (!m_steadyError)
+            {
+                m_steadyError = std::current_exception();
+            }
+            m_steadyStop = true;
+        }
+
+        std::lock_guard<std::mutex>  lock(m_steadySync);
+        --m_birthsInFlight;
+        m_steadySignal.notify_all();
+    }
+
+    // Replaces the worst individual of the steady-state population with the given individual if it's better.
+    // Pinned parents are never replaced, the individual is dropped instead. Must be called with m_steadySync locked.
+    void ReplaceWorstLive(std::span<const T> genome, double fitness)
+    {
+        auto IsBetter = [&](std::size_t left, std::size_t right) { return IsLiveBetter(left, right); };
+
+        // Heaps keep their worst individual in front.
+        auto & worstHeap = m_restHeap.empty() ? m_parentHeap : m_restHeap;
+        std::size_t worst = worstHeap.front();
+        if (fitness <= m_liveFitness[worst] || m_parentPins[worst] > 0)
+        {
+            return;
+        }
+
+        std::pop_heap(worstHeap.begin(), worstHeap.end(), IsBetter);
+        worstHeap.pop_back();
+
+        auto slot = GetGenome(m_nextGenomes, worst);
+        std::copy(genome.begin(), genome.end(), slot.begin());
+        m_liveFitness[worst] = fitness;
+        m_nextHashes[worst] = HashGenome(slot);
+
+        if (&worstHeap == &m_restHeap && IsBetter(worst, m_parentHeap.front()))
+        {
+            // The new individual becomes a parent and the weakest parent moves to the rest.
+            std::pop_heap(m_parentHeap.begin(), m_parentHeap.end(), IsBetter);
+            m_restHeap.emplace_back(m_parentHeap.back());
+            std::push_heap(m_restHeap.begin(), m_restHeap.end(), IsBetter);
+            m_parentHeap.back() = worst;
+            std::push_heap(m_parentHeap.begin(), m_parentHeap.end(), IsBetter);
+        }
+        else
+        {
+            worstHeap.emplace_back(worst);
+            std::push_heap(worstHeap.begin(), worstHeap.end(), IsBetter);
+        }
+    }
+
+    // Copies the steady-state population to the current generation. Must be called with m_steadySync locked.
+    void PublishSteadyState()
+    {
+        std::copy(m_nextGenomes.begin(), m_nextGenomes.end(), m_genomes.begin());
+        m_fitness = m_liveFitness;
+        m_hashes = m_nextHashes;
+    }
+
+    // Returns true if the first individual of the steady-state population is better than the second one.
+    bool IsLiveBetter(std::size_t left, std::size_t right) const
+    {
+        return m_liveFitness[left] > m_liveFitness[right] || (m_liveFitness[left] == m_liveFitness[right] && left < right);
+    }
+
+    // Returns genome of the individual at the given index of a genome buffer.
+    std::span<T> GetGenome(GenomeBuffer & buffer, std::size_t index)
+    {
+        return {buffer.data() + index * m_genomeStride, m_geneticMaterialLength};
+    }
 
-        return Individual<T>{childValue};
+    std::span<const T> GetGenome(const GenomeBuffer & buffer, std::size_t index) const
+    {
+        return {buffer.data() + index * m_genomeStride, m_geneticMaterialLength};
     }
 
-    // Calculates population fitness values in parallel.
-    void CalculatePopulationFitnessValues()
+    void CreateChild(std::span<const T> mother, std::span<const T> father, std::span<T> child, uint32_t generation,
+                     std::size_t individual, const std::size_t parentRatio, const std::size_t mutateProbability)
     {
-        // Create thread pool to calculate fitness functions.
-        ThreadPool  tp(std::thread::hardware_concurrency());
+        // Choose the parent of each gene first as a bit mask, then blend genes of both parents at once.
+        thread_local std::vector<uint64_t>  motherMask;
+        motherMask.resize((m_geneticMaterialLength + 63) / 64);
+
+        RandomStream  crossoverRng(m_seed, generation, individual, kCrossoverStream);
+        if (parentRatio == 50)
+        {
+            // Every random bit is a fair coin flip.
+            for (auto & word : motherMask)
+            {
+                word = crossoverRng.NextUInt64();
+            }
+        }
+        else
+        {
+            // Each 16-bit random number is compared against the ratio.
+            auto threshold = static_cast<uint32_t>((parentRatio * 65536 + 50) / 100);
+            for (auto & word : motherMask)
+            {
+                word = 0;
+                for (std::size_t bit=0; bit<64; bit += 2)
+                {
+                    uint32_t bits = crossoverRng();
+                    word |= static_cast<uint64_t>((bits & 0xFFFF) < threshold) << bit;
+                    word |= static_cast<uint64_t>((bits >> 16) < threshold) << (bit + 1);
+                }
+            }
+        }
+
+        if constexpr (std::is_same_v<T, double>)
+        {
+            kernels::GetKernels().selectGenes(mother.data(), father.data(), motherMask.data(), child.data(),
+                                              m_geneticMaterialLength);
+        }
+        else
+        {
+            for (size_t i=0; i < m_geneticMaterialLength; ++i)
+            {
+                child[i] = (motherMask[i / 64] >> (i % 64)) & 1 ? mother[i] : father[i];
+            }
+        }
+
+        if (mutateProbability == 0)
+        {
+            return;
+        }
+
+        // Mutate genes. Instead of a draw per gene, the distance to the next mutated gene is drawn from the geometric
+        // distribution, so the cost is proportional to the number of mutations.
+        RandomStream  mutationRng(m_seed, generation, individual, kMutationStream);
+        double logKeepProbability = std::log1p(-static_cast<double>(mutateProbability) / 100.0);
+        std::size_t i = 0;
+        while (i < m_geneticMaterialLength)
+        {
+            if (mutateProbability < 100)
+            {
+                double skip = std::floor(std::log(1.0 - mutationRng.NextDouble()) / logKeepProbability);
+                if (skip >= static_cast<double>(m_geneticMaterialLength - i))
+                {
+                    break;
+                }
+                i += static_cast<std::size_t>(skip);
+            }
+
+            RandomStream  geneRng(m_seed, generation, individual, kFirstGeneStream + i);
+            child[i] = m_randomItemFunc(geneRng);
+            ++i;
+        }
+    }
+
+    // Calculates fitness values of the current population. Individuals found in knownFitness are not evaluated
+    // unless they are among the first elitesCount individuals and elites are re-evaluated.
+    void CalculatePopulationFitnessValues(const std::unordered_map<uint64_t, double> & knownFitness,
+                                          std::size_t elitesCount)
+    {
+        bool useCache = m_fitnessCachePolicy != FitnessCachePolicy::kFitnessCachePolicyOff;
+        bool reevaluateElites = m_fitnessCachePolicy == FitnessCachePolicy::kFitnessCachePolicyReevaluateElites;
+
+        std::vector<std::size_t>  pending;      // Individuals to evaluate.
+        std::vector<std::size_t>  duplicates;   // Individuals with the same genome as a pending individual.
+        std::unordered_map<uint64_t, std::size_t>  pendingByHash;
+
+        for (std::size_t i=0; i<m_maxPopulation; ++i)
+        {
+            if (useCache)
+            {
+                if (pendingByHash.contains(m_hashes[i]))
+                {
+                    duplicates.emplace_back(i);
+                    continue;
+                }
+
+                auto it = knownFitness.find(m_hashes[i]);
+                if (it != knownFitness.end() && !(reevaluateElites && i < elitesCount))
+                {
+                    m_fitness[i] = it->second;
+                    continue;
+                }
+
+                pendingByHash.emplace(m_hashes[i], i);
+            }
+
+            pending.emplace_back(i);
+        }
+
+        if (m_populationFitnessFunc)
+        {
+            std::vector<std::span<const T>>  values;
+            for (auto i : pending)
+            {
+                values.emplace_back(GetGenome(m_genomes, i));
+            }
+
+            auto fitnesses = m_populationFitnessFunc(values, *m_threadPool);
+            if (fitnesses.size() != values.size())
+            {
+                throw std::runtime_error("Population fitness function returned wrong number of values.");
+            }
+
+            for (std::size_t p=0; p<pending.size(); ++p)
+            {
+                m_fitness[pending[p]] = fitnesses[p];
+            }
+        }
+        else if (m_batchFitnessFunc)
+        {
+            CalculateFitnessValuesInBatches(pending);
+        }
+        else
+        {
+            CalculateFitnessValues(pending);
+        }
+
+        for (auto i : duplicates)
+        {
+            m_fitness[i] = m_fitness[pendingByHash[m_hashes[i]]];
+        }
+
+        m_evaluationCount = pending.size();
+    }
+
+    // Calculates fitness values of the given individuals in parallel.
+    void CalculateFitnessValues(const std::vector<std::size_t> & indices)
+    {
+        auto & tp = *m_threadPool;
 
         // Calculate fitness values in parallel.
         std::vector<std::future<void>>  results;
-        for (std::size_t i=0; i<m_maxPopulation; ++i)
+        for (auto index : indices)
         {
             auto futureRet = tp.Enqueue([&](std::size_t i)
             {
-                auto & individual = m_population[i];
-                individual.SetFitness(m_fitnessFunc(individual.GetValue()));
-            }, i);
+                m_fitness[i] = m_fitnessFunc(GetGenome(m_genomes, i));
+            }, index);
 
             results.emplace_back(std::move(futureRet));
         }
 
         // Wait until all tasks are finished.
-        for (std::size_t i=0; i<m_maxPopulation; ++i)
+        for (auto & result : results)
         {
-            results[i].wait();
-            results[i].get();     // We don't have a return value but this will rethrow an uncaught exception.
+            result.wait();
+            result.get();     // We don't have a return value but this will rethrow an uncaught exception.
         }
     }
 
-    std::size_t GetRandomNumber(std::size_t min, std::size_t max)
+    // Calculates fitness values of the given individuals in parallel. Each task evaluates a batch of individuals.
+    void CalculateFitnessValuesInBatches(const std::vector<std::size_t> & indices)
     {
-        return std::uniform_int_distribution<std::size_t>(min, max)(m_rndEngine);
+        // Keep all threads busy even if there are only a few individuals.
+        std::size_t batchSize = std::min(m_maxBatchSize, (indices.size() + m_threadCount - 1) / m_threadCount);
+        batchSize = std::max<std::size_t>(batchSize, 1);
+
+        auto & tp = *m_threadPool;
+
+        std::vector<std::future<void>>  results;
+        for (std::size_t first=0; first<indices.size(); first += batchSize)
+        {
+            auto futureRet = tp.Enqueue([&](std::size_t first)
+            {
+                std::size_t last = std::min(first + batchSize, indices.size());
+
+                std::vector<std::span<const T>>  values;
+                for (std::size_t i=first; i<last; ++i)
+                {
+                    values.emplace_back(GetGenome(m_genomes, indices[i]));
+                }
+
+                auto fitnesses = m_batchFitnessFunc(values);
+                if (fitnesses.size() != values.size())
+                {
+                    throw std::runtime_error("Batch fitness function returned wrong number of values.");
+                }
+
+                for (std::size_t i=first; i<last; ++i)
+                {
+                    m_fitness[indices[i]] = fitnesses[i - first];
+                }
+            }, first);
+
+            results.emplace_back(std::move(futureRet));
+        }
+
+        // Wait until all tasks are finished.
+        for (auto & result : results)
+        {
+            result.wait();
+            result.get();     // We don't have a return value but this will rethrow an uncaught exception.
+        }
     }
 
-    // Sorts all individuals in current population based on their fitness values. The highest value is the best.
-    void SortIndividuals()
+    // Returns 64-bit hash of a genome. Genomes with the same hash are considered identical.
+    static uint64_t HashGenome(std::span<const T> genome)
     {
-        std::sort(m_population.begin(), m_population.end(), [](const Individual<T> & left, const Individual<T> & right)
+        static_assert(std::is_trivially_copyable_v<T>, "Genes must be trivially copyable to be hashed.");
+
+        // FNV-1a over 64-bit words, followed by a final avalanche.
+        const auto * bytes = reinterpret_cast<const unsigned char *>(genome.data());
+        std::size_t size = genome.size_bytes();
+        uint64_t hash = 0xCBF29CE484222325;
+
+        std::size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
         {
-            return left.GetFitness() > right.GetFitness();
-        });
+            uint64_t word;
+            std::memcpy(&word, bytes + i, sizeof(word));
+            hash = (hash ^ word) * 0x100000001B3;
+        }
+        for (; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 0x100000001B3;
+        }
+
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCD;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    // Ranks the individuals of the current population by fitness. The highest value is the best. Only the individuals
+    // used as parents or transferred to the next generation are ranked, the order of the rest is unspecified.
+    // Ties are broken by the index, so the ranking doesn't depend on the selection algorithm.
+    void RankIndividuals()
+    {
+        PerfScope  perfScope(PerfRegion::kPerfRegionRank);
+
+        auto IsBetter = [&](std::size_t left, std::size_t right)
+        {
+            return m_fitness[left] > m_fitness[right] || (m_fitness[left] == m_fitness[right] && left < right);
+        };
+
+        std::iota(m_ranking.begin(), m_ranking.end(), 0);
+
+        if (m_maxPopulation < kParallelRankingThreshold || m_threadCount == 1)
+        {
+            SelectTop(m_ranking.begin(), m_ranking.end(), m_rankedCount, IsBetter);
+            return;
+        }
+
+        // Each task sorts its own chunk of the population, then the best of the sorted chunks are merged.
+        std::size_t chunkSize = (m_maxPopulation + m_threadCount - 1) / m_threadCount;
+        std::vector<std::pair<std::size_t, std::size_t>>  chunks;     // [first, last) of each chunk.
+        for (std::size_t first=0; first<m_maxPopulation; first += chunkSize)
+        {
+            chunks.emplace_back(first, std::min(first + chunkSize, m_maxPopulation));
+        }
+
+        auto & tp = *m_threadPool;
+
+        std::vector<std::future<void>>  results;
+        for (const auto & chunk : chunks)
+        {
+            auto futureRet = tp.Enqueue([&](std::size_t first, std::size_t last)
+            {
+                PerfScope  perfScope(PerfRegion::kPerfRegionRank);
+                SelectTop(m_ranking.begin() + static_cast<std::ptrdiff_t>(first),
+                          m_ranking.begin() + static_cast<std::ptrdiff_t>(last), m_rankedCount, IsBetter);
+            }, chunk.first, chunk.second);
+
+            results.emplace_back(std::move(futureRet));
+        }
+
+        // Wait until all tasks are finished.
+        for (auto & result : results)
+        {
+            result.wait();
+            result.get();     // We don't have a return value but this will rethrow an uncaught exception.
+        }
+
+        // Merge the sorted heads of the chunks until the ranked count is reached. The heap keeps the chunk with the
+        // best next individual on top.
+        std::vector<std::size_t>  heads;        // Next position of each chunk.
+        std::vector<std::size_t>  headLasts;    // End of the sorted head of each chunk.
+        for (const auto & chunk : chunks)
+        {
+            heads.emplace_back(chunk.first);
+            headLasts.emplace_back(std::min(chunk.first + m_rankedCount, chunk.second));
+        }
+
+        auto IsChunkWorse = [&](std::size_t left, std::size_t right)
+        {
+            return IsBetter(m_ranking[heads[right]], m_ranking[heads[left]]);
+        };
+        std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(IsChunkWorse)>  heap(IsChunkWorse);
+        for (std::size_t c=0; c<chunks.size(); ++c)
+        {
+            heap.push(c);
+        }
+
+        std::vector<std::size_t>  ranked;
+        ranked.reserve(m_rankedCount);
+        while (ranked.size() < m_rankedCount)
+        {
+            std::size_t c = heap.top();
+            heap.pop();
+            ranked.emplace_back(m_ranking[heads[c]++]);
+            if (heads[c] < headLasts[c])
+            {
+                heap.push(c);
+            }
+        }
+
+        // Ranked individuals come first, the rest of the population follows in any order.
+        std::vector<uint8_t>  isRanked(m_maxPopulation, 0);
+        for (auto index : ranked)
+        {
+            isRanked[index] = 1;
+        }
+
+        std::copy(ranked.begin(), ranked.end(), m_ranking.begin());
+        std::size_t next = m_rankedCount;
+        for (std::size_t i=0; i<m_maxPopulation; ++i)
+        {
+            if (!isRanked[i])
+            {
+                m_ranking[next++] = i;
+            }
+        }
+    }
+
+    // Moves the best count items of [first, last) to the front in sorted order.
+    template<typename Iterator, typename Compare>
+    static void SelectTop(Iterator first, Iterator last, std::size_t count, Compare compare)
+    {
+        auto middle = first + static_cast<std::ptrdiff_t>(std::min<std::size_t>(count, last - first));
+        if (middle != last)
+        {
+            std::nth_element(first, middle, last, compare);
+        }
+        std::sort(first, middle, compare);
     }
 
 private:
-    std::vector<Individual<T>>  m_population;
+    static constexpr std::size_t  kAlignment = 64;
+    static constexpr std::size_t  kParallelRankingThreshold = 65536;    // Smaller populations are ranked serially.
+
+    // Stream ids of an individual in a generation. Each gene has its own stream starting from kFirstGeneStream.
+    static constexpr uint32_t  kParentStream    = 0;
+    static constexpr uint32_t  kCrossoverStream = 1;
+    static constexpr uint32_t  kMutationStream  = 2;
+    static constexpr uint32_t  kFirstGeneStream = 3;
+
+    GenomeBuffer  m_genomes;                // Current generation.
+    GenomeBuffer  m_nextGenomes;            // Next generation is bred into this buffer. Steady-state births
+                                            // replace individuals in this buffer.
+    std::vector<double>       m_fitness;    // Fitness values of the current generation.
+    std::vector<uint64_t>     m_hashes;     // Genome hashes of the current generation.
+    std::vector<uint64_t>     m_nextHashes; // Genome hashes of the next generation.
+    std::vector<std::size_t>  m_ranking;    // Indices of the current generation. The first m_rankedCount are sorted
+                                            // by fitness. Best first.
+    std::size_t  m_genomeStride;
     std::size_t  m_maxPopulation;
     std::size_t  m_parentRatio;
     std::size_t  m_mutateProbability;
     std::size_t  m_transferCount;
     std::size_t  m_crossoverThreshold;
     std::size_t  m_newIndividualsPerGeneration;
+    std::size_t  m_rankedCount;
     std::size_t  m_geneticMaterialLength;
+    uint64_t     m_seed;
+    std::size_t  m_threadCount;
+    std::vector<int>  m_cpus;
+    std::unique_ptr<ThreadPool>  m_threadPool;
+    uint32_t     m_generation{0};
+
+    std::function<double(std::span<const T> value)>   m_fitnessFunc;
+    std::function<std::vector<double>(const std::vector<std::span<const T>> & values)>   m_batchFitnessFunc;
+    std::function<std::vector<double>(const std::vector<std::span<const T>> & values,
+                                      ThreadPool & threadPool)>   m_populationFitnessFunc;
+    std::size_t          m_maxBatchSize{1};
+    FitnessCachePolicy   m_fitnessCachePolicy{FitnessCachePolicy::kFitnessCachePolicyOn};
+    std::size_t          m_evaluationCount{0};
+    GenerationTimes      m_generationTimes;
+    std::function<T(RandomStream & rng)>   m_randomItemFunc;
 
-    std::function<double(const std::vector<T> & value)>   m_fitnessFunc;
-    std::function<T()>   m_randomItemFunc;
-    std::mt19937         m_rndEngine;
+    // Steady-state evolution. Everything below and the buffers of the next generation are guarded by m_steadySync
+    // while births are running.
+    std::mutex               m_steadySync;
+    std::condition_variable  m_steadySignal;
+    std::vector<double>      m_liveFitness;     // Fitness values of the steady-state population.
+    std::vector<std::size_t> m_parentHeap;      // Best individuals, which are the parents. Worst on top.
+    std::vector<std::size_t> m_restHeap;        // All other individuals. Worst on top.
+    std::vector<uint32_t>    m_parentPins;      // Number of births breeding from each individual.
+    std::exception_ptr       m_steadyError;
+    uint32_t     m_steadyFirstGeneration{0};
+    std::size_t  m_startedBirths{0};
+    std::size_t  m_finishedBirths{0};
+    std::size_t  m_publishedBirths{0};
+    std::size_t  m_steadyTarget{0};
+    std::size_t  m_birthsInFlight{0};
+    bool         m_steadyStop{false};
+    bool         m_steadyRunning{false};     // Only changed by the thread that owns the population.
 };
 
 
+// Genetic algorithm. The population can be split into islands that evolve independently on their own threads and
+// exchange their best individuals periodically.
 template<typename T>
 class GeneticAlgorithm
 {
@@ -259,36 +1187,165 @@ public:
     GeneticAlgorithm(const std::size_t maxPopulation, const std::size_t parentRatio,
                      const std::size_t mutateProbability, const std::size_t transferRatio,
                      const std::size_t crossover, const std::size_t geneticMaterialLength) :
-            m_population{maxPopulation, parentRatio, mutateProbability, transferRatio, crossover, geneticMaterialLength},
+            m_maxPopulation{maxPopulation},
+            m_parentRatio{parentRatio},
+            m_mutateProbability{mutateProbability},
+            m_transferRatio{transferRatio},
+            m_crossover{crossover},
+            m_geneticMaterialLength{geneticMaterialLength},
             m_generation{0}
     {
+        std::random_device  rndDev;
+        m_seed = (static_cast<uint64_t>(rndDev()) << 32) | rndDev();
+    }
+
+    void SetFitnessFunc(std::function<double(std::span<const T> value)>&& func)
+    {
+        m_fitnessFunc = std::move(func);
+    }
+
+    void SetBatchFitnessFunc(std::function<std::vector<double>(const std::vector<std::span<const T>> & values)>&& func,
+                             std::size_t maxBatchSize)
+    {
+        m_batchFitnessFunc = std::move(func);
+        m_maxBatchSize = maxBatchSize;
+    }
+
+    void SetPopulationFitnessFunc(std::function<std::vector<double>(const std::vector<std::span<const T>> & values,
+                                                                    ThreadPool & threadPool)>&& func)
+    {
+        m_populationFitnessFunc = std::move(func);
+    }
+
+    void SetRandomItemFunc(std::function<T(RandomStream & rng)>&& func)
+    {
+        m_randomItemFunc = std::move(func);
+    }
+
+    void SetSeed(uint64_t seed)
+    {
+        m_seed = seed;
+    }
+
+    void SetFitnessCachePolicy(FitnessCachePolicy policy)
+    {
+        m_fitnessCachePolicy = policy;
+    }
+
+    // Splits the population into islands. Every migrationInterval generations, the best migrantCount individuals of
+    // each island replace the worst individuals of the receiving islands. Each island runs on its own slice of CPUs.
+    void SetIslands(std::size_t islandCount, std::size_t migrationInterval, std::size_t migrantCount,
+                    MigrationTopology topology)
+    {
+        m_islandCount = std::clamp<std::size_t>(islandCount, 1, m_maxPopulation);
+        m_migrationInterval = std::max<std::size_t>(migrationInterval, 1);
+        m_migrantCount = migrantCount;
+        m_migrationTopology = topology;
+    }
+
+    // Enables steady-state evolution. Births run continuously on each island and each generation ends after population
+    // size more births.
+    void SetSteadyState(bool steadyState)
+    {
+        m_steadyState = steadyState;
+    }
+
+    // Returns the number of fitness evaluations of the last generation.
+    std::size_t GetEvaluationCount() const
+    {
+        std::size_t count = 0;
+        for (const auto & island : m_islands)
+        {
+            count += island->GetEvaluationCount();
+        }
+        return count;
+    }
+
+    // Returns the time spent in each phase of the last generation. Islands run in parallel, so each phase takes as
+    // long as on the slowest island.
+    GenerationTimes GetGenerationTimes() const
+    {
+        GenerationTimes  times;
+        for (const auto & island : m_islands)
+        {
+            times.breed    = std::max(times.breed, island->GetGenerationTimes().breed);
+            times.evaluate = std::max(times.evaluate, island->GetGenerationTimes().evaluate);
+            times.rank     = std::max(times.rank, island->GetGenerationTimes().rank);
+        }
+        return times;
+    }
+
+    // Returns fitness values of all individuals of the current generation.
+    std::vector<double> GetFitnessValues() const
+    {
+        std::vector<double>  fitness;
+        for (const auto & island : m_islands)
+        {
+            fitness.insert(fitness.end(), island->GetFitnessValues().begin(), island->GetFitnessValues().end());
+        }
+        return fitness;
     }
 
-    void SetFitnessFunc(std::function<double(const std::vector<T> & value)>&& func)
+    // Returns the number of threads of all islands.
+    std::size_t GetThreadCount() const
     {
-        m_population.SetFitnessFunc(std::move(func));
+        std::size_t count = 0;
+        for (const auto & island : m_islands)
+        {
+            count += island->GetThreadCount();
+        }
+        return count;
     }
 
-    void SetRandomItemFunc(std::function<T()>&& func)
+    // Returns total time (seconds) the threads of all islands have spent running tasks.
+    double GetThreadBusyTime() const
     {
-        m_population.SetRandomItemFunc(std::move(func));
+        double busyTime = 0;
+        for (const auto & island : m_islands)
+        {
+            busyTime += island->GetThreadBusyTime();
+        }
+        return busyTime;
     }
 
     void CreateInitialPopulation()
     {
+        CreateIslands();
+
         m_generation = 1;
-        m_population.CreateInitialGeneration();
+        RunOnIslands([](Population<T> & island) { island.CreateInitialGeneration(); });
     }
 
     void CreateNextPopulation()
     {
         m_generation++;
-        m_population.CreateNextGeneration();
+        if (m_steadyState)
+        {
+            RunOnIslands([](Population<T> & island) { island.EvolveSteadyState(island.GetSize()); });
+        }
+        else
+        {
+            RunOnIslands([](Population<T> & island) { island.CreateNextGeneration(); });
+        }
+
+        if (m_islands.size() > 1 && (m_generation - 1) % m_migrationInterval == 0)
+        {
+            Migrate();
+        }
     }
 
-    const Individual<T> & GetBestIndividual() const
+    // Returns the best individual of all islands.
+    Individual<T> GetBestIndividual() const
     {
-        return m_population.GetBestIndividual();
+        std::size_t best = 0;
+        for (std::size_t i=1; i<m_islands.size(); ++i)
+        {
+            if (m_islands[i]->GetBestIndividual().GetFitness() > m_islands[best]->GetBestIndividual().GetFitness())
+            {
+                best = i;
+            }
+        }
+        return m_islands[best]->GetBestIndividual();
     }
 
     std::size_t GetGeneration() const
@@ -296,9 +1353,200 @@ public:
         return m_generation;
     }
 
+    // Writes the whole state of the algorithm to the stream. Fitness and random item functions are not written.
+    void Save(std::ostream & stream) const
+    {
+        auto WriteUInt64 = [&](uint64_t val) { stream.write(reinterpret_cast<const char*>(&val), sizeof(val)); };
+
+        WriteUInt64(m_generation);
+        WriteUInt64(m_seed);
+        WriteUInt64(m_islandCount);
+        WriteUInt64(m_migrationInterval);
+        WriteUInt64(m_migrantCount);
+        WriteUInt64(static_cast<uint64_t>(m_migrationTopology));
+
+        for (const auto & island : m_islands)
+        {
+            island->Save(stream);
+        }
+    }
+
+    // Restores the state written by Save(). It replaces CreateInitialPopulation() and the algorithm continues exactly
+    // where it was saved. Functions must be set before, and population parameters must match.
+    // Returns false if the stream is not compatible or can't be read.
+    bool Load(std::istream & stream)
+    {
+        auto ReadUInt64 = [&]() { uint64_t val{0}; stream.read(reinterpret_cast<char*>(&val), sizeof(val)); return val; };
+
+        m_generation = ReadUInt64();
+        m_seed = ReadUInt64();
+        m_islandCount = ReadUInt64();
+        m_migrationInterval = ReadUInt64();
+        m_migrantCount = ReadUInt64();
+        m_migrationTopology = static_cast<MigrationTopology>(ReadUInt64());
+
+        if (!stream || m_islandCount < 1 || m_islandCount > m_maxPopulation || m_migrationInterval < 1)
+        {
+            return false;
+        }
+
+        CreateIslands();
+
+        for (auto & island : m_islands)
+        {
+            if (!island->Load(stream))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
 private:
-    Population<T>   m_population;
+    void CreateIslands()
+    {
+        m_islands.clear();
+
+        auto cpus = ThreadPool::GetAvailableCpus();
+
+        for (std::size_t k=0; k<m_islandCount; ++k)
+        {
+            // Individuals that don't divide evenly go to the first islands.
+            std::size_t islandSize = m_maxPopulation / m_islandCount + (k < m_maxPopulation % m_islandCount ? 1 : 0);
+            auto island = std::make_unique<Population<T>>(islandSize, m_parentRatio, m_mutateProbability,
+                                                          m_transferRatio, m_crossover, m_geneticMaterialLength);
+
+            if (m_islandCount == 1)
+            {
+                island->SetSeed(m_seed);
+                island->SetThreads(cpus.size(), {});
+            }
+            else
+            {
+                // Each island has its own random streams and its own slice of CPUs. Islands share CPUs if there are
+                // more islands than CPUs.
+                island->SetSeed(RandomStream(m_seed, kIslandSeedGeneration, k).NextUInt64());
+
+                std::size_t first = k * cpus.size() / m_islandCount;
+                std::size_t last  = std::max((k + 1) * cpus.size() / m_islandCount, first + 1);
+                std::vector<int>  islandCpus;
+                for (std::size_t c=first; c<last; ++c)
+                {
+                    islandCpus.emplace_back(cpus[c % cpus.size()]);
+                }
+                island->SetThreads(islandCpus.size(), islandCpus);
+            }
+
+            island->SetFitnessFunc(std::function<double(std::span<const T> value)>(m_fitnessFunc));
+            if (m_batchFitnessFunc)
+            {
+                island->SetBatchFitnessFunc(
+                        std::function<std::vector<double>(const std::vector<std::span<const T>> &)>(m_batchFitnessFunc),
+                        m_maxBatchSize);
+            }
+            if (m_populationFitnessFunc)
+            {
+                island->SetPopulationFitnessFunc(
+                        std::function<std::vector<double>(const std::vector<std::span<const T>> &, ThreadPool &)>(
+                                m_populationFitnessFunc));
+            }
+            island->SetRandomItemFunc(std::function<T(RandomStream & rng)>(m_randomItemFunc));
+            island->SetFitnessCachePolicy(m_fitnessCachePolicy);
+
+            m_islands.emplace_back(std::move(island));
+        }
+    }
+
+    // Runs the given function on all islands in parallel.
+    void RunOnIslands(const std::function<void(Population<T> & island)> & func)
+    {
+        if (m_islands.size() == 1)
+        {
+            func(*m_islands.front());
+            return;
+        }
+
+        std::vector<std::future<void>>  results;
+        for (auto & island : m_islands)
+        {
+            results.emplace_back(std::async(std::launch::async, [&func, &island]() { func(*island); }));
+        }
+
+        // Wait until all islands are finished.
+        for (auto & result : results)
+        {
+            result.wait();
+            result.get();     // We don't have a return value but this will rethrow an uncaught exception.
+        }
+    }
+
+    // Sends the best individuals of each island to the receiving islands of the topology.
+    void Migrate()
+    {
+        TraceScope  traceScope("Migrate");
+        std::size_t islandCount = m_islands.size();
+
+        // Take copies of all migrants first, so that the order of the islands doesn't matter.
+        std::vector<std::vector<std::vector<T>>>  migrants(islandCount);
+        std::vector<std::vector<double>>          migrantFitness(islandCount);
+        for (std::size_t k=0; k<islandCount; ++k)
+        {
+            std::size_t count = std::min(m_migrantCount, m_islands[k]->GetRankedCount());
+            for (std::size_t rank=0; rank<count; ++rank)
+            {
+                auto individual = m_islands[k]->GetIndividual(rank);
+                migrants[k].emplace_back(individual.GetValue().begin(), individual.GetValue().end());
+                migrantFitness[k].emplace_back(individual.GetFitness());
+            }
+        }
+
+        for (std::size_t k=0; k<islandCount; ++k)
+        {
+            std::vector<std::vector<T>>  genomes;
+            std::vector<double>          fitness;
+
+            for (std::size_t source=0; source<islandCount; ++source)
+            {
+                bool isNeighbor = m_migrationTopology == MigrationTopology::kMigrationTopologyRing ?
+                                  (source + 1) % islandCount == k : source != k;
+                if (isNeighbor)
+                {
+                    genomes.insert(genomes.end(), migrants[source].begin(), migrants[source].end());
+                    fitness.insert(fitness.end(), migrantFitness[source].begin(), migrantFitness[source].end());
+                }
+            }
+
+            m_islands[k]->Immigrate(genomes, fitness);
+        }
+    }
+
+private:
+    static constexpr uint32_t  kIslandSeedGeneration = 0xFFFFFFFE;    // Stream generation of the island seeds.
+
+    std::vector<std::unique_ptr<Population<T>>>  m_islands;
+    std::size_t     m_maxPopulation;
+    std::size_t     m_parentRatio;
+    std::size_t     m_mutateProbability;
+    std::size_t     m_transferRatio;
+    std::size_t     m_crossover;
+    std::size_t     m_geneticMaterialLength;
     std::size_t     m_generation;
+    uint64_t        m_seed;
+
+    bool               m_steadyState{false};
+    std::size_t        m_islandCount{1};
+    std::size_t        m_migrationInterval{10};
+    std::size_t        m_migrantCount{2};
+    MigrationTopology  m_migrationTopology{MigrationTopology::kMigrationTopologyRing};
+
+    std::function<double(std::span<const T> value)>   m_fitnessFunc;
+    std::function<std::vector<double>(const std::vector<std::span<const T>> & values)>   m_batchFitnessFunc;
+    std::function<std::vector<double>(const std::vector<std::span<const T>> & values,
+                                      ThreadPool & threadPool)>   m_populationFitnessFunc;
+    std::size_t          m_maxBatchSize{1};
+    std::function<T(RandomStream & rng)>   m_randomItemFunc;
+    FitnessCachePolicy   m_fitnessCachePolicy{FitnessCachePolicy::kFitnessCachePolicyOn};
 };
 
 } // namespace ga
@@ -0,0 +1,56 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+
+// Project includes
+#include "Kernels.hpp"
+// External includes
+// System includes
+
+
+namespace kernels
+{
+
+namespace
+{
+
+const KernelTable & SelectKernels()
+{
+#if defined(KERNELS_X86)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq"))
+    {
+        return GetKernelsAVX512();
+    }
+
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        return GetKernelsAVX2();
+    }
+
+    if (__builtin_cpu_supports("sse4.2"))
+    {
+        return GetKernelsSSE4();
+    }
+#endif
+
+    return GetKernelsGeneric();
+}
+
+} // namespace
+
+
+const KernelTable & GetKernels()
+{
+    static const KernelTable & kernelTable = SelectKernels();
+    return kernelTable;
+}
+
+} // namespace kernels
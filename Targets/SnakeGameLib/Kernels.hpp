@@ -0,0 +1,55 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#pragma once
+
+// Project includes
+// External includes
+// System includes
+#include <cstddef>
+#include <cstdint>
+
+
+namespace kernels
+{
+
+// Hot compute kernels compiled for a specific instruction set. All matrices are row-major.
+struct KernelTable
+{
+    // Name of the instruction set.
+    const char * name;
+
+    // out[r][o] = biases[o] + sum(in[r][i] * weights[i][o])
+    void (*denseForward)(const double * in, std::size_t rows, std::size_t inputSize, const double * weights,
+                         const double * biases, std::size_t outputSize, double * out);
+
+    // Element-wise activations. Applied in-place. Sigmoid, tanh and softmax are the generic ones in all variants.
+    void (*sigmoid)(double * data, std::size_t size);
+    void (*tanh)(double * data, std::size_t size);
+    void (*relu)(double * data, std::size_t size);
+    void (*leakyRelu)(double * data, std::size_t size);
+
+    // Row-wise softmax. Applied in-place.
+    void (*softmax)(double * data, std::size_t rows, std::size_t cols);
+
+    // child[i] = bit i of motherMask ? mother[i] : father[i]
+    void (*selectGenes)(const double * mother, const double * father, const uint64_t * motherMask, double * child,
+                        std::size_t size);
+};
+
+// Returns kernels of the best instruction set supported by the CPU. The selection is made once on the first call.
+const KernelTable & GetKernels();
+
+// Instruction set variants. Only the variants of the target architecture are compiled.
+const KernelTable & GetKernelsGeneric();
+const KernelTable & GetKernelsSSE4();
+const KernelTable & GetKernelsAVX2();
+const KernelTable & GetKernelsAVX512();
+
+} // namespace kernels
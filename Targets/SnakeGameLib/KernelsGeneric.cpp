@@ -0,0 +1,14 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#define KERNELS_NAME        "generic"
+#define KERNELS_TABLE_FUNC  GetKernelsGeneric
+#define KERNELS_GENERIC
+
+#include "KernelsImpl.hpp"
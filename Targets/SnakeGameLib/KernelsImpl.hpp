@@ -0,0 +1,179 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+// Kernel implementations shared by all instruction set variants. Each variant source file defines KERNELS_NAME and
+// KERNELS_TABLE_FUNC, includes this file and is compiled with its own instruction set flags. The generic variant also
+// defines KERNELS_GENERIC.
+//
+// Everything here must have internal linkage. An inline or template function would be merged with the copies of the
+// other variants by the linker, and an AVX-512 copy could end up running on a CPU without AVX-512. That's also why
+// no Eigen or STL algorithms are used here.
+
+#if !defined(KERNELS_NAME) || !defined(KERNELS_TABLE_FUNC)
+#error "KERNELS_NAME and KERNELS_TABLE_FUNC must be defined before including KernelsImpl.hpp"
+#endif
+
+// Project includes
+#include "Kernels.hpp"
+// External includes
+// System includes
+#include <cmath>
+
+
+namespace kernels
+{
+
+namespace
+{
+
+void DenseForward(const double * __restrict in, std::size_t rows, std::size_t inputSize,
+                  const double * __restrict weights, const double * __restrict biases, std::size_t outputSize,
+                  double * __restrict out)
+{
+    for (std::size_t r=0; r<rows; ++r)
+    {
+        const double * x = in + r * inputSize;
+        double * y = out + r * outputSize;
+
+        for (std::size_t o=0; o<outputSize; ++o)
+        {
+            y[o] = biases[o];
+        }
+
+        // The inner loop runs over contiguous outputs, so it vectorizes without reordering the sums.
+        for (std::size_t i=0; i<inputSize; ++i)
+        {
+            const double xi = x[i];
+            const double * w = weights + i * outputSize;
+            for (std::size_t o=0; o<outputSize; ++o)
+            {
+                y[o] += xi * w[o];
+            }
+        }
+    }
+}
+
+
+#if defined(KERNELS_GENERIC)
+
+// Activations that call exp() compile into a scalar call per element in every variant, since there is no vector exp()
+// that gives the same results. They are compiled only in the generic variant and shared by the others.
+
+void Sigmoid(double * data, std::size_t size)
+{
+    for (std::size_t i=0; i<size; ++i)
+    {
+        data[i] = 1.0 / (1.0 + std::exp(-data[i]));
+    }
+}
+
+
+void Tanh(double * data, std::size_t size)
+{
+    for (std::size_t i=0; i<size; ++i)
+    {
+        double expX = std::exp(data[i]);
+        double expMinusX = std::exp(-data[i]);
+        data[i] = (expX - expMinusX) / (expX + expMinusX);
+    }
+}
+
+
+void Softmax(double * data, std::size_t rows, std::size_t cols)
+{
+    for (std::size_t r=0; r<rows; ++r)
+    {
+        double * row = data + r * cols;
+        double sumExp = 0;
+        for (std::size_t c=0; c<cols; ++c)
+        {
+            row[c] = std::exp(row[c]);
+            sumExp += row[c];
+        }
+        for (std::size_t c=0; c<cols; ++c)
+        {
+            row[c] /= sumExp;
+        }
+    }
+}
+
+#endif
+
+
+void ReLU(double * data, std::size_t size)
+{
+    for (std::size_t i=0; i<size; ++i)
+    {
+        data[i] = data[i] > 0 ? data[i] : 0;
+    }
+}
+
+
+void LeakyReLU(double * data, std::size_t size)
+{
+    for (std::size_t i=0; i<size; ++i)
+    {
+        data[i] = data[i] > 0 ? data[i] : data[i] * 0.001;
+    }
+}
+
+
+void SelectGenes(const double * __restrict mother, const double * __restrict father,
+                 const uint64_t * __restrict motherMask, double * __restrict child, std::size_t size)
+{
+    // Full 64-gene words. The inner loop is branch-free so that it compiles into vector blends.
+    std::size_t words = size / 64;
+    for (std::size_t w=0; w<words; ++w)
+    {
+        uint64_t mask = motherMask[w];
+        const double * __restrict m = mother + w * 64;
+        const double * __restrict f = father + w * 64;
+        double * __restrict c = child + w * 64;
+        for (std::size_t i=0; i<64; ++i)
+        {
+            c[i] = (mask >> i) & 1 ? m[i] : f[i];
+        }
+    }
+
+    for (std::size_t i=words * 64; i<size; ++i)
+    {
+        child[i] = (motherMask[i / 64] >> (i % 64)) & 1 ? mother[i] : father[i];
+    }
+}
+
+} // namespace
+
+
+const KernelTable & KERNELS_TABLE_FUNC()
+{
+    static const KernelTable  kernelTable
+    {
+        KERNELS_NAME,
+        DenseForward,
+#if defined(KERNELS_GENERIC)
+        Sigmoid,
+        Tanh,
+#else
+        GetKernelsGeneric().sigmoid,
+        GetKernelsGeneric().tanh,
+#endif
+        ReLU,
+        LeakyReLU,
+#if defined(KERNELS_GENERIC)
+        Softmax,
+#else
+        GetKernelsGeneric().softmax,
+#endif
+        SelectGenes,
+    };
+
+    return kernelTable;
+}
+
+} // namespace kernels
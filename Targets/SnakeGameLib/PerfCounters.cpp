@@ -0,0 +1,208 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+// Project includes
+#include "PerfCounters.hpp"
+// External includes
+// System includes
+#include <utility>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace
+{
+
+#if defined(__linux__)
+
+constexpr std::size_t  kEventCount = static_cast<std::size_t>(PerfEvent::kPerfEventCount);
+
+// Returns type and config of the perf event.
+std::pair<uint32_t, uint64_t> GetEventConfig(PerfEvent event)
+{
+    constexpr uint64_t kReadMiss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+    switch (event)
+    {
+        case PerfEvent::kPerfEventCycles:       return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES};
+        case PerfEvent::kPerfEventInstructions: return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS};
+        case PerfEvent::kPerfEventL1DMisses:    return {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | kReadMiss};
+        case PerfEvent::kPerfEventLLCMisses:    return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES};
+        case PerfEvent::kPerfEventBranchMisses: return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES};
+        default: return {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES};
+    }
+}
+
+// Opens a counter of the calling thread. Returns the file descriptor or -1 on failure.
+int OpenEvent(PerfEvent event, int groupFd)
+{
+    perf_event_attr  attr{};
+    attr.size = sizeof(attr);
+    attr.type = GetEventConfig(event).first;
+    attr.config = GetEventConfig(event).second;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+// Counters of a thread. All events are in one group led by the cycle counter, so they are read at once and they
+// count exactly the same instructions.
+struct ThreadCounters
+{
+    ThreadCounters()
+    {
+        int leaderFd = OpenEvent(PerfEvent::kPerfEventCycles, -1);
+        if (leaderFd < 0)
+        {
+            return;
+        }
+
+        fds.fill(-1);
+        slots.fill(-1);
+        fds[0] = leaderFd;
+        slots[0] = 0;
+        slotCount = 1;
+
+        for (std::size_t e=1; e<kEventCount; ++e)
+        {
+            fds[e] = OpenEvent(static_cast<PerfEvent>(e), leaderFd);
+            if (fds[e] >= 0)
+            {
+                slots[e] = static_cast<int>(slotCount++);
+            }
+        }
+    }
+
+    ~ThreadCounters()
+    {
+        for (auto fd : fds)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+    }
+
+    bool IsOpen() const
+    {
+        return slotCount > 0;
+    }
+
+    // Returns bit mask of the opened events.
+    uint32_t GetEventMask() const
+    {
+        uint32_t mask = 0;
+        for (std::size_t e=0; e<kEventCount; ++e)
+        {
+            mask |= slots[e] >= 0 ? 1u << e : 0;
+        }
+        return mask;
+    }
+
+    bool Read(PerfCounts & counts) const
+    {
+        // Group read format: number of events, then the value of each event in the order they were opened.
+        uint64_t  buffer[1 + kEventCount]{};
+        if (!IsOpen() || read(fds[0], buffer, sizeof(buffer)) < static_cast<ssize_t>(sizeof(uint64_t) * (1 + slotCount)))
+        {
+            return false;
+        }
+
+        for (std::size_t e=0; e<kEventCount; ++e)
+        {
+            counts.values[e] = slots[e] >= 0 ? buffer[1 + slots[e]] : 0;
+        }
+        return true;
+    }
+
+    std::array<int, kEventCount>  fds{};
+    std::array<int, kEventCount>  slots{};      // Position of each event in the group read.
+    std::size_t  slotCount{0};
+};
+
+ThreadCounters & GetThreadCounters()
+{
+    thread_local ThreadCounters  counters;
+    return counters;
+}
+
+#endif
+
+}
+
+
+bool PerfCounters::Start()
+{
+#if defined(__linux__)
+    // Availability is checked on the calling thread. Other threads have the same permissions and the same CPU.
+    auto & counters = GetThreadCounters();
+    if (!counters.IsOpen())
+    {
+        return false;
+    }
+
+    for (auto & region : m_counts)
+    {
+        for (auto & count : region)
+        {
+            count = 0;
+        }
+    }
+
+    m_availableEvents = counters.GetEventMask();
+    m_enabled = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+void PerfCounters::Stop()
+{
+    m_enabled = false;
+}
+
+
+PerfCounts PerfCounters::GetCounts(PerfRegion region)
+{
+    PerfCounts  counts;
+    const auto & regionCounts = m_counts[static_cast<std::size_t>(region)];
+    for (std::size_t e=0; e<kEventCount; ++e)
+    {
+        counts.values[e] = regionCounts[e].load(std::memory_order_relaxed);
+    }
+    return counts;
+}
+
+
+bool PerfCounters::ReadThreadCounts(PerfCounts & counts)
+{
+#if defined(__linux__)
+    return GetThreadCounters().Read(counts);
+#else
+    (void)counts;
+    return false;
+#endif
+}
+
+
+void PerfCounters::AddCounts(PerfRegion region, const PerfCounts & counts)
+{
+    auto & regionCounts = m_counts[static_cast<std::size_t>(region)];
+    for (std::size_t e=0; e<kEventCount; ++e)
+    {
+        regionCounts[e].fetch_add(counts.values[e], std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,139 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#pragma once
+
+// Project includes
+// External includes
+// System includes
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+
+// Hardware events counted by the performance counters.
+enum class PerfEvent : int32_t
+{
+    kPerfEventCycles       = 0,
+    kPerfEventInstructions = 1,
+    kPerfEventL1DMisses    = 2,     // L1 data cache read misses.
+    kPerfEventLLCMisses    = 3,     // Last level cache misses.
+    kPerfEventBranchMisses = 4,
+    kPerfEventCount        = 5,
+};
+
+
+// Code regions measured by the performance counters.
+enum class PerfRegion : int32_t
+{
+    kPerfRegionBreed    = 0,    // Creating children.
+    kPerfRegionRank     = 1,    // Ranking individuals.
+    kPerfRegionSimulate = 2,    // Playing snake games.
+    kPerfRegionCount    = 3,
+};
+
+
+// Event counts of a region.
+struct PerfCounts
+{
+    uint64_t & operator[](PerfEvent event)
+    {
+        return values[static_cast<std::size_t>(event)];
+    }
+
+    uint64_t operator[](PerfEvent event) const
+    {
+        return values[static_cast<std::size_t>(event)];
+    }
+
+    // Returns instructions per cycle.
+    double GetIPC() const
+    {
+        auto cycles = (*this)[PerfEvent::kPerfEventCycles];
+        return cycles > 0 ? double((*this)[PerfEvent::kPerfEventInstructions]) / double(cycles) : 0;
+    }
+
+    std::array<uint64_t, static_cast<std::size_t>(PerfEvent::kPerfEventCount)>  values{};
+};
+
+
+// Counts hardware events of code regions with the perf_event_open interface of Linux. Each thread opens its own
+// counters the first time it enters a region, and the events of a region are summed over all threads. Only user
+// space events are counted. Disabled by default, a region costs a single flag check while disabled.
+class PerfCounters
+{
+public:
+    // Starts counting. Returns false if the counters are not available, for example on other platforms or if the
+    // kernel doesn't allow it (see /proc/sys/kernel/perf_event_paranoid).
+    static bool Start();
+
+    // Stops counting.
+    static void Stop();
+
+    // Returns true if events are being counted.
+    static bool IsEnabled()
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    // Returns true if the event is supported by the CPU. Unsupported events are always zero.
+    static bool IsAvailable(PerfEvent event)
+    {
+        return (m_availableEvents.load(std::memory_order_relaxed) >> static_cast<uint32_t>(event)) & 1;
+    }
+
+    // Returns total event counts of a region since the start.
+    static PerfCounts GetCounts(PerfRegion region);
+
+    // Reads the counters of the calling thread. Returns false if the thread has no counters.
+    static bool ReadThreadCounts(PerfCounts & counts);
+
+    // Adds event counts of a region.
+    static void AddCounts(PerfRegion region, const PerfCounts & counts);
+
+private:
+    static constexpr std::size_t  kEventCount  = static_cast<std::size_t>(PerfEvent::kPerfEventCount);
+    static constexpr std::size_t  kRegionCount = static_cast<std::size_t>(PerfRegion::kPerfRegionCount);
+
+    static inline std::atomic<bool>      m_enabled{false};
+    static inline std::atomic<uint32_t>  m_availableEvents{0};     // Bit mask of PerfEvent.
+    static inline std::array<std::array<std::atomic<uint64_t>, kEventCount>, kRegionCount>  m_counts{};
+};
+
+
+// Counts events of the calling thread from construction to destruction if the counters are enabled.
+class PerfScope
+{
+public:
+    explicit PerfScope(PerfRegion region) : m_region{region}
+    {
+        m_active = PerfCounters::IsEnabled() && PerfCounters::ReadThreadCounts(m_begin);
+    }
+
+    ~PerfScope()
+    {
+        PerfCounts  end;
+        if (m_active && PerfCounters::ReadThreadCounts(end))
+        {
+            for (std::size_t e=0; e<end.values.size(); ++e)
+            {
+                end.values[e] -= m_begin.values[e];
+            }
+            PerfCounters::AddCounts(m_region, end);
+        }
+    }
+
+    PerfScope(const PerfScope &) = delete;
+    PerfScope & operator=(const PerfScope &) = delete;
+
+private:
+    PerfRegion  m_region;
+    PerfCounts  m_begin;
+    bool        m_active{false};
+};
@@ -0,0 +1,141 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#pragma once
+
+// Project includes
+// External includes
+// System includes
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+
+
+namespace ga
+{
+
+// Counter-based random number stream built on Philox4x32-10. A stream is identified by a seed and three 32-bit ids,
+// which the genetic algorithm uses as (generation, individual, gene). The n-th number of a stream is a pure function of
+// its identity and n, so streams can be created in any order and on any thread without sharing state.
+// Satisfies the UniformRandomBitGenerator requirements.
+class RandomStream
+{
+public:
+    using result_type = uint32_t;
+
+    // Constructor
+    RandomStream(uint64_t seed, uint32_t generation, uint32_t individual, uint32_t gene = 0) :
+        m_key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)},
+        m_streamId{gene, individual, generation}
+    {
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    // Returns next 32-bit random number.
+    result_type operator()()
+    {
+        if (m_outputIndex == m_output.size())
+        {
+            m_output = GenerateBlock(m_blockIndex++);
+            m_outputIndex = 0;
+        }
+        return m_output[m_outputIndex++];
+    }
+
+    // Returns next 64-bit random number.
+    uint64_t NextUInt64()
+    {
+        uint64_t low = (*this)();
+        return (static_cast<uint64_t>((*this)()) << 32) | low;
+    }
+
+    // Returns a random number in [0, 1).
+    double NextDouble()
+    {
+        return static_cast<double>(NextUInt64() >> 11) * 0x1.0p-53;
+    }
+
+    // Returns a random number in [min, max).
+    double Uniform(double min, double max)
+    {
+        return min + (max - min) * NextDouble();
+    }
+
+    // Returns a standard normally distributed random number. Box-Muller transform, the second value of each pair is
+    // returned by the next call.
+    double Normal()
+    {
+        if (m_hasSpareNormal)
+        {
+            m_hasSpareNormal = false;
+            return m_spareNormal;
+        }
+
+        double radius = std::sqrt(-2.0 * std::log1p(-NextDouble()));     // 1 - u is in (0, 1].
+        double angle  = 2.0 * std::numbers::pi * NextDouble();
+
+        m_spareNormal = radius * std::sin(angle);
+        m_hasSpareNormal = true;
+        return radius * std::cos(angle);
+    }
+
+    // Returns an unbiased random integer in [0, n). n must be in [1, 2^32].
+    std::size_t UniformIndex(std::size_t n)
+    {
+        // Lemire's multiply-shift method. Products that fall into the biased range are rejected.
+        uint64_t range = n;
+        uint64_t product = static_cast<uint64_t>((*this)()) * range;
+        if (static_cast<uint32_t>(product) < range)
+        {
+            auto threshold = static_cast<uint32_t>((uint64_t(1) << 32) % range);
+            while (static_cast<uint32_t>(product) < threshold)
+            {
+                product = static_cast<uint64_t>((*this)()) * range;
+            }
+        }
+        return static_cast<std::size_t>(product >> 32);
+    }
+
+private:
+    // Philox4x32-10 bijection of the counter (block index, stream id) under the key.
+    std::array<uint32_t, 4> GenerateBlock(uint32_t blockIndex) const
+    {
+        std::array<uint32_t, 4>  ctr{blockIndex, m_streamId[0], m_streamId[1], m_streamId[2]};
+        std::array<uint32_t, 2>  key = m_key;
+
+        for (int round=0; round<10; ++round)
+        {
+            uint64_t product0 = static_cast<uint64_t>(0xD2511F53) * ctr[0];
+            uint64_t product1 = static_cast<uint64_t>(0xCD9E8D57) * ctr[2];
+
+            ctr = {static_cast<uint32_t>(product1 >> 32) ^ ctr[1] ^ key[0], static_cast<uint32_t>(product1),
+                   static_cast<uint32_t>(product0 >> 32) ^ ctr[3] ^ key[1], static_cast<uint32_t>(product0)};
+
+            key[0] += 0x9E3779B9;
+            key[1] += 0xBB67AE85;
+        }
+
+        return ctr;
+    }
+
+private:
+    std::array<uint32_t, 2>  m_key;
+    std::array<uint32_t, 3>  m_streamId;
+    uint32_t                 m_blockIndex{0};
+    std::array<uint32_t, 4>  m_output{};
+    std::size_t              m_outputIndex{4};
+    double                   m_spareNormal{0};
+    bool                     m_hasSpareNormal{false};
+};
+
+} // namespace ga
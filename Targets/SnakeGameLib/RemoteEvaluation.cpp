@@ -0,0 +1,909 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+// Project includes
+#include "RemoteEvaluation.hpp"
+#include "ThreadPool.hpp"
+#include "Trace.hpp"
+// External includes
+// System includes
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <stdexcept>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define REMOTE_EVALUATION_SUPPORTED
+#endif
+
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t  kProtocolMagic   = 0x49414E53;      // "SNAI"
+constexpr uint32_t  kProtocolVersion = 3;
+constexpr uint32_t  kMaxPayloadSize  = 1u << 28;
+constexpr uint32_t  kMaxHelloSize    = 4096;        // Connections can't send more before they are authenticated.
+
+// Size of a result in the Result message.
+constexpr std::size_t  kResultSize = sizeof(double) + 6 * sizeof(uint64_t);
+
+// Each worker holds up to this many genomes per CPU, so the next batch is already there when a batch is finished.
+constexpr std::size_t  kPipelineDepth = 2;
+
+constexpr auto  kHeartbeatInterval = std::chrono::seconds(1);
+constexpr auto  kHeartbeatTimeout  = std::chrono::seconds(15);
+constexpr auto  kConnectTimeout    = std::chrono::seconds(60);
+constexpr int   kPollIntervalMs    = 100;
+constexpr auto  kPollInterval      = std::chrono::milliseconds(kPollIntervalMs);
+
+// Messages of the protocol. Each message starts with its type and payload size as uint32 values.
+//   Hello:     worker -> coordinator. magic, version, thread count, token size, token.
+//   Job:       coordinator -> worker. genome length, genome precision, job description.
+//   Batch:     coordinator -> worker. batch id, genome count, genome values.
+//   Result:    worker -> coordinator. batch id, genome count, results. Each result is the fitness value followed by
+//              games, steps, forward calls, allocations, deallocations and allocated bytes as uint64 values.
+//   Heartbeat: both ways, no payload. Sent when nothing else is sent for a while.
+enum class MessageType : uint32_t
+{
+    kMessageTypeHello     = 0,
+    kMessageTypeJob       = 1,
+    kMessageTypeBatch     = 2,
+    kMessageTypeResult    = 3,
+    kMessageTypeHeartbeat = 4,
+};
+
+// Appends a value to the payload.
+template<typename T>
+void Put(std::vector<uint8_t> & payload, T value)
+{
+    auto size = payload.size();
+    payload.resize(size + sizeof(T));
+    std::memcpy(payload.data() + size, &value, sizeof(T));
+}
+
+// Reads a value from the payload. Returns false if the payload is too short.
+template<typename T>
+bool Get(std::span<const uint8_t> & payload, T & value)
+{
+    if (payload.size() < sizeof(T))
+    {
+        return false;
+    }
+    std::memcpy(&value, payload.data(), sizeof(T));
+    payload = payload.subspan(sizeof(T));
+    return true;
+}
+
+#if defined(REMOTE_EVALUATION_SUPPORTED)
+
+#if defined(MSG_NOSIGNAL)
+constexpr int  kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int  kSendFlags = 0;
+#endif
+
+// Prepares a connected socket for the protocol.
+void ConfigureSocket(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+#if defined(SO_NOSIGPIPE)
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+}
+
+#endif
+
+// Buffered message stream over a non-blocking socket.
+struct Channel
+{
+    explicit Channel(int socket) : fd{socket}, lastReceive{Clock::now()}, lastSend{Clock::now()} { }
+
+    // Queues a message to send.
+    void Send(MessageType type, std::span<const uint8_t> payload = {})
+    {
+        Put(output, static_cast<uint32_t>(type));
+        Put(output, static_cast<uint32_t>(payload.size()));
+        output.insert(output.end(), payload.begin(), payload.end());
+        lastSend = Clock::now();
+    }
+
+    bool HasOutput() const
+    {
+        return outputPos < output.size();
+    }
+
+    // Sends as much of the queued messages as the socket accepts. Returns false on errors.
+    bool Flush()
+    {
+#if defined(REMOTE_EVALUATION_SUPPORTED)
+        while (HasOutput())
+        {
+            auto sent = send(fd, output.data() + outputPos, output.size() - outputPos, kSendFlags);
+            if (sent < 0)
+            {
+                return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+            }
+            outputPos += sent;
+        }
+        output.clear();
+        outputPos = 0;
+#endif
+        return true;
+    }
+
+    // Receives available data. Returns false on errors or if the peer closed the connection.
+    bool Receive()
+    {
+#if defined(REMOTE_EVALUATION_SUPPORTED)
+        uint8_t  buffer[65536];
+        for (;;)
+        {
+            auto received = recv(fd, buffer, sizeof(buffer), 0);
+            if (received == 0)
+            {
+                closed = true;
+                return false;
+            }
+            if (received < 0)
+            {
+                return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+            }
+            input.insert(input.end(), buffer, buffer + received);
+            lastReceive = Clock::now();
+        }
+#else
+        return false;
+#endif
+    }
+
+    // Calls the handler for each complete message received. Returns false if a message is invalid or larger than
+    // the maximum payload size.
+    template<typename Handler>
+    bool Parse(Handler && handler, uint32_t maxPayloadSize = kMaxPayloadSize)
+    {
+        std::size_t pos = 0;
+        bool valid = true;
+        while (valid && input.size() - pos >= 2 * sizeof(uint32_t))
+        {
+            std::span<const uint8_t>  header(input.data() + pos, 2 * sizeof(uint32_t));
+            uint32_t type = 0;
+            uint32_t size = 0;
+            Get(header, type);
+            Get(header, size);
+
+            if (size > maxPayloadSize)
+            {
+                valid = false;
+                break;
+            }
+            if (input.size() - pos - 2 * sizeof(uint32_t) < size)
+            {
+                break;
+            }
+
+            valid = handler(type, std::span<const uint8_t>(input.data() + pos + 2 * sizeof(uint32_t), size));
+            pos += 2 * sizeof(uint32_t) + size;
+        }
+
+        input.erase(input.begin(), input.begin() + static_cast<std::ptrdiff_t>(pos));
+        return valid;
+    }
+
+    void Close()
+    {
+#if defined(REMOTE_EVALUATION_SUPPORTED)
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+#endif
+        fd = -1;
+    }
+
+    int  fd{-1};
+    bool closed{false};
+    std::vector<uint8_t>  input;
+    std::vector<uint8_t>  output;
+    std::size_t  outputPos{0};
+    Clock::time_point  lastReceive;
+    Clock::time_point  lastSend;
+};
+
+}
+
+
+// Connection of a remote worker.
+struct RemoteEvaluator::Connection
+{
+    explicit Connection(int fd) : channel{fd} { }
+
+    Channel  channel;
+    bool     ready{false};              // Hello is received and the job is sent.
+    std::size_t  threadCount{1};
+    std::size_t  outstandingGenomes{0};
+    std::map<uint64_t, std::vector<uint32_t>>  batches;     // Genome indices of the unfinished batches.
+};
+
+
+RemoteEvaluator::RemoteEvaluator(uint16_t port, std::string token, std::size_t genomeLength, std::vector<uint8_t> job,
+                                 GenomePrecision precision) :
+        m_token{std::move(token)},
+        m_genomeLength{genomeLength},
+        m_job{std::move(job)},
+        m_precision{precision}
+{
+#if defined(REMOTE_EVALUATION_SUPPORTED)
+    m_listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (m_listenSocket < 0)
+    {
+        throw std::runtime_error("Can't create the coordinator socket.");
+    }
+
+    int enable = 1;
+    setsockopt(m_listenSocket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in  address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(m_listenSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(m_listenSocket, 64) != 0 || pipe(m_wakeUpPipe) != 0)
+    {
+        close(m_listenSocket);
+        throw std::runtime_error("Can't listen on port " + std::to_string(port));
+    }
+    fcntl(m_listenSocket, F_SETFL, fcntl(m_listenSocket, F_GETFL) | O_NONBLOCK);
+    fcntl(m_wakeUpPipe[0], F_SETFL, fcntl(m_wakeUpPipe[0], F_GETFL) | O_NONBLOCK);
+
+    m_networkThread = std::thread([this]() { NetworkThreadFunc(); });
+#else
+    (void)port;
+    throw std::runtime_error("Remote evaluation is not supported on this platform.");
+#endif
+}
+
+
+RemoteEvaluator::~RemoteEvaluator()
+{
+#if defined(REMOTE_EVALUATION_SUPPORTED)
+    {
+        std::lock_guard<std::mutex>  lock(m_sync);
+        m_exitNow = true;
+    }
+    WakeUp();
+    m_networkThread.join();
+
+    close(m_listenSocket);
+    close(m_wakeUpPipe[0]);
+    close(m_wakeUpPipe[1]);
+#endif
+}
+
+
+std::vector<EvaluationResult> RemoteEvaluator::Evaluate(const std::vector<std::span<const double>> & genomes)
+{
+    std::lock_guard<std::mutex>  evaluateLock(m_evaluateSync);
+    TraceScope  traceScope("EvaluateRemote");
+    if (genomes.empty())
+    {
+        return {};
+    }
+
+    std::unique_lock<std::mutex>  lock(m_sync);
+    m_genomes.resize(genomes.size() * m_genomeLength);
+    for (std::size_t i=0; i<genomes.size(); ++i)
+    {
+        if (genomes[i].size() != m_genomeLength)
+        {
+            throw std::runtime_error("Genome length does not match the remote evaluator.");
+        }
+        std::copy(genomes[i].begin(), genomes[i].end(), m_genomes.begin() + i * m_genomeLength);
+    }
+
+    m_results.assign(genomes.size(), {});
+    m_pendingGenomes.resize(genomes.size());
+    for (std::size_t i=0; i<genomes.size(); ++i)
+    {
+        m_pendingGenomes[i] = static_cast<uint32_t>(i);
+    }
+    m_remainingGenomes = genomes.size();
+
+    lock.unlock();
+    WakeUp();
+    lock.lock();
+
+    // The wait wakes up periodically to check the interrupt function, since no worker may be connected at all.
+    while (!m_doneSignal.wait_for(lock, kPollInterval, [this]() { return m_remainingGenomes == 0 || m_exitNow; }))
+    {
+        if (m_interruptFunc && m_interruptFunc())
+        {
+            // Results of the abandoned batches are ignored when they arrive.
+            m_pendingGenomes.clear();
+            for (auto & connection : m_connections)
+            {
+                connection->batches.clear();
+                connection->outstandingGenomes = 0;
+            }
+            m_remainingGenomes = 0;
+            throw RemoteEvaluationInterrupted();
+        }
+    }
+
+    if (m_remainingGenomes > 0)
+    {
+        throw RemoteEvaluationInterrupted();
+    }
+    return m_results;
+}
+
+
+std::size_t RemoteEvaluator::GetWorkerCount() const
+{
+    std::lock_guard<std::mutex>  lock(m_sync);
+    return m_workerCount;
+}
+
+
+std::size_t RemoteEvaluator::GetRedispatchCount() const
+{
+    std::lock_guard<std::mutex>  lock(m_sync);
+    return m_redispatchCount;
+}
+
+
+void RemoteEvaluator::NetworkThreadFunc()
+{
+#if defined(REMOTE_EVALUATION_SUPPORTED)
+    std::vector<pollfd>  pollFds;
+
+    for (;;)
+    {
+        {
+            std::lock_guard<std::mutex>  lock(m_sync);
+            if (m_exitNow)
+            {
+                break;
+            }
+
+            pollFds.clear();
+            pollFds.push_back({m_wakeUpPipe[0], POLLIN, 0});
+            pollFds.push_back({m_listenSocket, POLLIN, 0});
+            for (const auto & connection : m_connections)
+            {
+                short events = POLLIN | (connection->channel.HasOutput() ? POLLOUT : 0);
+                pollFds.push_back({connection->channel.fd, events, 0});
+            }
+        }
+
+        poll(pollFds.data(), pollFds.size(), kPollIntervalMs);
+
+        std::lock_guard<std::mutex>  lock(m_sync);
+
+        uint8_t  drain[64];
+        while (read(m_wakeUpPipe[0], drain, sizeof(drain)) > 0) { }
+
+        // Only this thread changes the connection list, so poll results match the first connections.
+        std::size_t polledCount = pollFds.size() - 2;
+        for (std::size_t i=0; i<polledCount; ++i)
+        {
+            auto & connection = *m_connections[i];
+            if (pollFds[i + 2].revents & (POLLIN | POLLHUP | POLLERR))
+            {
+                bool received = connection.channel.Receive();
+                bool valid = connection.channel.Parse([&](uint32_t type, std::span<const uint8_t> payload)
+                {
+                    return HandleMessage(connection, type, payload);
+                }, connection.ready ? kMaxPayloadSize : kMaxHelloSize);
+                if (!received || !valid)
+                {
+                    DropConnection(connection);
+                }
+            }
+        }
+
+        if (pollFds[1].revents & POLLIN)
+        {
+            int fd;
+            while ((fd = accept(m_listenSocket, nullptr, nullptr)) >= 0)
+            {
+                ConfigureSocket(fd);
+                m_connections.emplace_back(std::make_unique<Connection>(fd));
+            }
+        }
+
+        auto now = Clock::now();
+        for (auto & connection : m_connections)
+        {
+            if (connection->channel.fd < 0)
+            {
+                continue;
+            }
+            if (now - connection->channel.lastReceive > kHeartbeatTimeout)
+            {
+                DropConnection(*connection);
+                continue;
+            }
+            if (connection->ready && now - connection->channel.lastSend > kHeartbeatInterval)
+            {
+                connection->channel.Send(MessageType::kMessageTypeHeartbeat);
+            }
+        }
+
+        DispatchBatches();
+
+        for (auto & connection : m_connections)
+        {
+            if (connection->channel.fd >= 0 && !connection->channel.Flush())
+            {
+                DropConnection(*connection);
+            }
+        }
+
+        std::erase_if(m_connections, [](const auto & connection) { return connection->channel.fd < 0; });
+    }
+
+    std::lock_guard<std::mutex>  lock(m_sync);
+    for (auto & connection : m_connections)
+    {
+        connection->channel.Close();
+    }
+    m_connections.clear();
+    m_workerCount = 0;
+    m_doneSignal.notify_all();
+#endif
+}
+
+
+bool RemoteEvaluator::HandleMessage(Connection & connection, uint32_t type, std::span<const uint8_t> payload)
+{
+    switch (static_cast<MessageType>(type))
+    {
+        case MessageType::kMessageTypeHello:
+        {
+            uint32_t magic = 0;
+            uint32_t version = 0;
+            uint32_t threadCount = 0;
+            uint32_t tokenSize = 0;
+            if (connection.ready || !Get(payload, magic) || !Get(payload, version) || !Get(payload, threadCount) ||
+                magic != kProtocolMagic || version != kProtocolVersion || !Get(payload, tokenSize) ||
+                tokenSize != payload.size())
+            {
+                return false;
+            }
+
+            // The whole token is compared, so the time doesn't tell how much of it matches.
+            if (tokenSize != m_token.size() || m_token.empty())
+            {
+                return false;
+            }
+            uint8_t difference = 0;
+            for (std::size_t i=0; i<tokenSize; ++i)
+            {
+                difference |= payload[i] ^ static_cast<uint8_t>(m_token[i]);
+            }
+            if (difference != 0)
+            {
+                return false;
+            }
+
+            connection.ready = true;
+            connection.threadCount = std::clamp<std::size_t>(threadCount, 1, 4096);
+            m_workerCount++;
+
+            std::vector<uint8_t>  job;
+            Put(job, static_cast<uint32_t>(m_genomeLength));
+            Put(job, static_cast<uint32_t>(m_precision));
+            job.insert(job.end(), m_job.begin(), m_job.end());
+            connection.channel.Send(MessageType::kMessageTypeJob, job);
+            return true;
+        }
+
+        case MessageType::kMessageTypeResult:
+        {
+            uint64_t batchId = 0;
+            uint32_t count = 0;
+            if (!Get(payload, batchId) || !Get(payload, count))
+            {
+                return false;
+            }
+
+            auto batch = connection.batches.find(batchId);
+            if (batch == connection.batches.end())
+            {
+                // Results of the batches of an interrupted evaluation.
+                return batchId < m_nextBatchId;
+            }
+            if (batch->second.size() != count || payload.size() != count * kResultSize)
+            {
+                return false;
+            }
+
+            for (auto index : batch->second)
+            {
+                auto & result = m_results[index];
+                Get(payload, result.fitness);
+                Get(payload, result.games);
+                Get(payload, result.steps);
+                Get(payload, result.forwardCalls);
+                Get(payload, result.allocCounts.allocations);
+                Get(payload, result.allocCounts.deallocations);
+                Get(payload, result.allocCounts.bytes);
+            }
+
+            connection.outstandingGenomes -= count;
+            m_remainingGenomes -= count;
+            connection.batches.erase(batch);
+
+            if (m_remainingGenomes == 0)
+            {
+                m_doneSignal.notify_all();
+            }
+            return true;
+        }
+
+        case MessageType::kMessageTypeHeartbeat:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+
+void RemoteEvaluator::DispatchBatches()
+{
+    std::size_t totalThreads = 0;
+    for (const auto & connection : m_connections)
+    {
+        totalThreads += connection->ready ? connection->threadCount : 0;
+    }
+    if (totalThreads == 0)
+    {
+        return;
+    }
+
+    // Batches are small enough to keep all CPUs of all workers busy.
+    std::size_t fairShare = (m_results.size() + totalThreads - 1) / totalThreads;
+    std::size_t elementSize = m_precision == GenomePrecision::kGenomePrecisionFloat ? sizeof(float) : sizeof(double);
+
+    // Batches are given to the workers in turns.
+    bool progress = true;
+    while (progress && !m_pendingGenomes.empty())
+    {
+        progress = false;
+        for (auto & connection : m_connections)
+        {
+            std::size_t capacity = kPipelineDepth * connection->threadCount;
+            if (!connection->ready || connection->channel.fd < 0 || m_pendingGenomes.empty() ||
+                connection->outstandingGenomes >= capacity)
+            {
+                continue;
+            }
+
+            std::size_t count = std::min({connection->threadCount, fairShare, m_pendingGenomes.size(),
+                                          capacity - connection->outstandingGenomes});
+            auto batchId = m_nextBatchId++;
+            auto & indices = connection->batches[batchId];
+
+            std::vector<uint8_t>  payload;
+            payload.reserve(sizeof(uint64_t) + sizeof(uint32_t) + count * m_genomeLength * elementSize);
+            Put(payload, batchId);
+            Put(payload, static_cast<uint32_t>(count));
+
+            for (std::size_t i=0; i<count; ++i)
+            {
+                auto index = m_pendingGenomes.front();
+                m_pendingGenomes.pop_front();
+                indices.emplace_back(index);
+
+                const double * genome = m_genomes.data() + index * m_genomeLength;
+                for (std::size_t j=0; j<m_genomeLength; ++j)
+                {
+                    if (m_precision == GenomePrecision::kGenomePrecisionFloat)
+                    {
+                        Put(payload, static_cast<float>(genome[j]));
+                    }
+                    else
+                    {
+                        Put(payload, genome[j]);
+                    }
+                }
+            }
+
+            connection->outstandingGenomes += count;
+            connection->channel.Send(MessageType::kMessageTypeBatch, payload);
+            progress = true;
+        }
+    }
+}
+
+
+void RemoteEvaluator::DropConnection(Connection & connection)
+{
+    if (connection.channel.fd < 0)
+    {
+        return;
+    }
+
+    connection.channel.Close();
+    if (connection.ready)
+    {
+        m_workerCount--;
+    }
+
+    // Lost genomes are evaluated first by the other workers.
+    for (auto batch = connection.batches.rbegin(); batch != connection.batches.rend(); ++batch)
+    {
+        m_pendingGenomes.insert(m_pendingGenomes.begin(), batch->second.begin(), batch->second.end());
+        m_redispatchCount++;
+    }
+    connection.batches.clear();
+    connection.outstandingGenomes = 0;
+}
+
+
+void RemoteEvaluator::WakeUp()
+{
+#if defined(REMOTE_EVALUATION_SUPPORTED)
+    uint8_t  signal = 1;
+    [[maybe_unused]] auto written = write(m_wakeUpPipe[1], &signal, sizeof(signal));
+#endif
+}
+
+
+RemoteWorker::RemoteWorker(std::string host, uint16_t port, std::string token) :
+        m_host{std::move(host)},
+        m_port{port},
+        m_token{std::move(token)}
+{
+}
+
+
+bool RemoteWorker::Run(const CreateFitnessFunc & createFitnessFunc)
+{
+#if defined(REMOTE_EVALUATION_SUPPORTED)
+    auto startTime = Clock::now();
+    int fd;
+    while ((fd = Connect()) < 0)
+    {
+        if (Clock::now() - startTime > kConnectTimeout)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    // A batch under evaluation. Results are sent back in the order of the batches.
+    struct Batch
+    {
+        uint64_t  id{0};
+        std::vector<double>  genomes;
+        std::vector<std::future<EvaluationResult>>  results;
+    };
+
+    Channel  channel(fd);
+    RemoteFitnessFunc  fitnessFunc;
+    std::size_t  genomeLength = 0;
+    GenomePrecision  precision{GenomePrecision::kGenomePrecisionDouble};
+    std::deque<Batch>  batches;
+
+    auto threadCount = ThreadPool::GetAvailableCpus().size();
+    // Declared after the batches, so all evaluations are finished before the batches are deleted.
+    ThreadPool  threadPool(threadCount);
+
+    std::vector<uint8_t>  hello;
+    Put(hello, kProtocolMagic);
+    Put(hello, kProtocolVersion);
+    Put(hello, static_cast<uint32_t>(threadCount));
+    Put(hello, static_cast<uint32_t>(m_token.size()));
+    hello.insert(hello.end(), m_token.begin(), m_token.end());
+    channel.Send(MessageType::kMessageTypeHello, hello);
+
+    // Handles a message received from the coordinator.
+    auto HandleMessage = [&](uint32_t type, std::span<const uint8_t> payload) -> bool
+    {
+        switch (static_cast<MessageType>(type))
+        {
+            case MessageType::kMessageTypeJob:
+            {
+                uint32_t length = 0;
+                uint32_t precisionValue = 0;
+                if (fitnessFunc || !Get(payload, length) || !Get(payload, precisionValue) || precisionValue > 1)
+                {
+                    return false;
+                }
+                genomeLength = length;
+                precision = static_cast<GenomePrecision>(precisionValue);
+                fitnessFunc = createFitnessFunc(genomeLength, payload);
+                return static_cast<bool>(fitnessFunc);
+            }
+
+            case MessageType::kMessageTypeBatch:
+            {
+                uint64_t batchId = 0;
+                uint32_t count = 0;
+                std::size_t elementSize = precision == GenomePrecision::kGenomePrecisionFloat ? sizeof(float)
+                                                                                              : sizeof(double);
+                if (!fitnessFunc || !Get(payload, batchId) || !Get(payload, count) ||
+                    payload.size() != count * genomeLength * elementSize)
+                {
+                    return false;
+                }
+
+                auto & batch = batches.emplace_back();
+                batch.id = batchId;
+                batch.genomes.resize(count * genomeLength);
+                for (auto & value : batch.genomes)
+                {
+                    if (precision == GenomePrecision::kGenomePrecisionFloat)
+                    {
+                        float floatValue = 0;
+                        Get(payload, floatValue);
+                        value = floatValue;
+                    }
+                    else
+                    {
+                        Get(payload, value);
+                    }
+                }
+
+                for (std::size_t i=0; i<count; ++i)
+                {
+                    std::span<const double>  genome(batch.genomes.data() + i * genomeLength, genomeLength);
+                    batch.results.emplace_back(threadPool.Enqueue([&fitnessFunc, genome]() -> EvaluationResult
+                    {
+                        // A failing evaluation gets the lowest fitness. Otherwise, it would fail on all workers.
+                        try
+                        {
+                            return fitnessFunc(genome);
+                        }
+                        catch (...)
+                        {
+                            EvaluationResult  failed;
+                            failed.fitness = std::numeric_limits<double>::lowest();
+                            return failed;
+                        }
+                    }));
+                }
+                return true;
+            }
+
+            case MessageType::kMessageTypeHeartbeat:
+                return true;
+
+            default:
+                return false;
+        }
+    };
+
+    bool success = true;
+    for (;;)
+    {
+        pollfd  pollFd{channel.fd, static_cast<short>(POLLIN | (channel.HasOutput() ? POLLOUT : 0)), 0};
+        poll(&pollFd, 1, batches.empty() ? kPollIntervalMs : 1);
+
+        if (pollFd.revents & (POLLIN | POLLHUP | POLLERR))
+        {
+            bool received = channel.Receive();
+            bool valid = channel.Parse(HandleMessage);
+            if (!received || !valid)
+            {
+                // The coordinator closes the connection when the training is finished. A connection closed before
+                // the job is received is rejected by the coordinator.
+                success = channel.closed && valid && fitnessFunc;
+                break;
+            }
+        }
+
+        // Send results of the finished batches.
+        while (!batches.empty() && std::all_of(batches.front().results.begin(), batches.front().results.end(),
+               [](const auto & result) { return result.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }))
+        {
+            auto & batch = batches.front();
+            std::vector<uint8_t>  message;
+            Put(message, batch.id);
+            Put(message, static_cast<uint32_t>(batch.results.size()));
+            for (auto & future : batch.results)
+            {
+                auto result = future.get();
+                Put(message, result.fitness);
+                Put(message, result.games);
+                Put(message, result.steps);
+                Put(message, result.forwardCalls);
+                Put(message, result.allocCounts.allocations);
+                Put(message, result.allocCounts.deallocations);
+                Put(message, result.allocCounts.bytes);
+            }
+            channel.Send(MessageType::kMessageTypeResult, message);
+            batches.pop_front();
+        }
+
+        auto now = Clock::now();
+        if (now - channel.lastReceive > kHeartbeatTimeout)
+        {
+            success = false;
+            break;
+        }
+        if (now - channel.lastSend > kHeartbeatInterval)
+        {
+            channel.Send(MessageType::kMessageTypeHeartbeat);
+        }
+
+        if (!channel.Flush())
+        {
+            success = false;
+            break;
+        }
+    }
+
+    // Wait for the running evaluations before the batches are deleted.
+    for (auto & batch : batches)
+    {
+        for (auto & result : batch.results)
+        {
+            result.wait();
+        }
+    }
+
+    channel.Close();
+    return success;
+#else
+    (void)createFitnessFunc;
+    return false;
+#endif
+}
+
+
+int RemoteWorker::Connect() const
+{
+#if defined(REMOTE_EVALUATION_SUPPORTED)
+    addrinfo  hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo * addresses = nullptr;
+    if (getaddrinfo(m_host.c_str(), std::to_string(m_port).c_str(), &hints, &addresses) != 0)
+    {
+        return -1;
+    }
+
+    int fd = -1;
+    for (auto address = addresses; address && fd < 0; address = address->ai_next)
+    {
+        fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd >= 0 && connect(fd, address->ai_addr, address->ai_addrlen) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+
+    if (fd >= 0)
+    {
+        ConfigureSocket(fd);
+    }
+    return fd;
+#else
+    return -1;
+#endif
+}
@@ -0,0 +1,160 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#pragma once
+
+// Project includes
+#include "EvaluationResult.hpp"
+// External includes
+// System includes
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Precision of the genome values sent to remote workers. Float halves the network traffic, but the remote fitness
+// values are calculated with rounded genomes.
+enum class GenomePrecision : uint32_t
+{
+    kGenomePrecisionDouble = 0,
+    kGenomePrecisionFloat  = 1,
+};
+
+
+// Fitness function of a remote worker. The counters of the result are sent back to the coordinator.
+using RemoteFitnessFunc = std::function<EvaluationResult(std::span<const double> value)>;
+
+
+// Thrown by RemoteEvaluator::Evaluate() if the evaluation is interrupted before all results are received.
+class RemoteEvaluationInterrupted : public std::runtime_error
+{
+public:
+    RemoteEvaluationInterrupted() : std::runtime_error("Remote evaluation is interrupted.")
+    {
+    }
+};
+
+
+// Coordinator of remote fitness evaluation. Listens for remote workers on a TCP port and distributes genome batches
+// to them. Each worker gets a few batches in advance so it never waits for the network. Workers and the coordinator
+// exchange heartbeats, and the batches of a lost worker are sent to the other workers again.
+// Workers can connect and leave at any time. Evaluation waits until at least one worker is connected.
+// Workers must present the shared token of the coordinator, other connections are closed.
+class RemoteEvaluator
+{
+public:
+    // Constructor. Starts listening on the given port. The job description is sent to each worker when it connects,
+    // and the worker creates its fitness function from it.
+    RemoteEvaluator(uint16_t port, std::string token, std::size_t genomeLength, std::vector<uint8_t> job,
+                    GenomePrecision precision = GenomePrecision::kGenomePrecisionDouble);
+
+    // Destructor. Disconnects all workers.
+    ~RemoteEvaluator();
+
+    RemoteEvaluator(const RemoteEvaluator &) = delete;
+    RemoteEvaluator & operator=(const RemoteEvaluator &) = delete;
+
+    // Returns results of the genomes. Thread-safe, concurrent calls are evaluated one after another.
+    // Throws RemoteEvaluationInterrupted if the interrupt function returns true while waiting for the results.
+    std::vector<EvaluationResult> Evaluate(const std::vector<std::span<const double>> & genomes);
+
+    // Sets the function that Evaluate() checks periodically while it waits for the workers.
+    void SetInterruptFunc(std::function<bool()> && func)
+    {
+        m_interruptFunc = std::move(func);
+    }
+
+    // Returns number of connected workers.
+    std::size_t GetWorkerCount() const;
+
+    // Returns number of batches that were sent again because their workers were lost.
+    std::size_t GetRedispatchCount() const;
+
+private:
+    struct Connection;
+
+    // Network thread main loop. Accepts workers, sends batches and receives results.
+    void NetworkThreadFunc();
+
+    // Handles a message received from a worker. Returns false if the message is invalid.
+    bool HandleMessage(Connection & connection, uint32_t type, std::span<const uint8_t> payload);
+
+    // Sends pending batches to the workers that have free pipeline slots.
+    void DispatchBatches();
+
+    // Closes the connection and puts its unfinished batches back to the pending list.
+    void DropConnection(Connection & connection);
+
+    // Wakes up the network thread.
+    void WakeUp();
+
+private:
+    std::string  m_token;
+    std::size_t  m_genomeLength;
+    std::vector<uint8_t>  m_job;
+    GenomePrecision  m_precision;
+    std::function<bool()>  m_interruptFunc;
+
+    int  m_listenSocket{-1};
+    int  m_wakeUpPipe[2]{-1, -1};
+    std::thread  m_networkThread;
+    bool  m_exitNow{false};
+
+    mutable std::mutex  m_sync;
+    std::condition_variable  m_doneSignal;
+    std::vector<std::unique_ptr<Connection>>  m_connections;
+    std::size_t  m_workerCount{0};
+    std::size_t  m_redispatchCount{0};
+    uint64_t     m_nextBatchId{0};
+
+    // State of the current evaluation.
+    std::vector<double>  m_genomes;
+    std::vector<EvaluationResult>  m_results;
+    std::deque<uint32_t> m_pendingGenomes;
+    std::size_t  m_remainingGenomes{0};
+
+    std::mutex  m_evaluateSync;
+};
+
+
+// Remote worker that evaluates genome batches of a coordinator with all CPUs of the machine.
+class RemoteWorker
+{
+public:
+    // Creates fitness function of a job that evaluates genomes of the given length. Returns an empty function if
+    // the job can't be evaluated.
+    using CreateFitnessFunc = std::function<RemoteFitnessFunc(std::size_t genomeLength, std::span<const uint8_t> job)>;
+
+    // Constructor. The token must match the token of the coordinator.
+    RemoteWorker(std::string host, uint16_t port, std::string token);
+
+    // Connects to the coordinator and evaluates its batches until the coordinator disconnects. Connection is retried
+    // for a while, so workers can be started before the coordinator. Returns false on connection or protocol errors.
+    bool Run(const CreateFitnessFunc & createFitnessFunc);
+
+private:
+    // Connects to the coordinator. Returns the socket or -1 on failure.
+    int Connect() const;
+
+private:
+    std::string  m_host;
+    uint16_t     m_port;
+    std::string  m_token;
+};
@@ -11,9 +11,47 @@
 #include "SnakeGame.hpp"
 // External includes
 // System includes
+#include <limits>
 #include <random>
 
 
+SnakeScenarioBank::SnakeScenarioBank(int boardWidth, int boardHeight, std::size_t gameCount, uint64_t seed) :
+        m_boardWidth{boardWidth},
+        m_boardHeight{boardHeight},
+        m_seed{seed}
+{
+    std::size_t cellCount = std::size_t(boardWidth) * boardHeight;
+    if (cellCount - 1 > std::numeric_limits<uint16_t>::max())
+    {
+        throw std::runtime_error("Board is too large for a scenario bank.");
+    }
+
+    if (GetMemorySize(boardWidth, boardHeight, gameCount) > kMaxMemorySize)
+    {
+        throw std::runtime_error("Too many games for a scenario bank of the board size.");
+    }
+
+    m_applesPerGame = GetApplesPerGame(boardWidth, boardHeight);
+
+    m_startPositions.reserve(gameCount);
+    m_appleCells.reserve(gameCount * m_applesPerGame);
+
+    for (std::size_t game=0; game<gameCount; ++game)
+    {
+        std::mt19937_64  rndEng(GetGameSeed(game));
+
+        m_startPositions.emplace_back(std::uniform_int_distribution<int>(2, boardWidth-2)(rndEng),
+                                      std::uniform_int_distribution<int>(2, boardHeight-2)(rndEng));
+
+        std::uniform_int_distribution<int>  cellDist(0, static_cast<int>(cellCount - 1));
+        for (std::size_t i=0; i<m_applesPerGame; ++i)
+        {
+            m_appleCells.emplace_back(static_cast<uint16_t>(cellDist(rndEng)));
+        }
+    }
+}
+
+
 void SnakeGame::Update()
 {
     if (m_gameState != SnakeGameState::kSnakeGameStateRunning)
@@ -22,6 +60,7 @@ void SnakeGame::Update()
     }
 
     m_steps++;    // Number of iterations until snake eats an apple.
+    m_totalSteps++;
 
     // If snake can't get the apple in 100 iterations than kill the game. Longer the same becomes
     // more chance to survive.
@@ -89,7 +128,14 @@ void SnakeGame::Update()
 
 void SnakeGame::Reset()
 {
+    if (m_scenarioBank)
+    {
+        Reset(m_scenario + 1);
+        return;
+    }
+
     m_steps = 0;
+    m_totalSteps = 0;
     m_score = 0;
     m_snake.clear();
     m_gameState = SnakeGameState::kSnakeGameStateRunning;
@@ -113,25 +159,107 @@ void SnakeGame::Reset()
 }
 
 
+void SnakeGame::Reset(std::size_t scenario)
+{
+    if (!m_scenarioBank || m_scenarioBank->GetGameCount() == 0)
+    {
+        throw std::runtime_error("Snake game has no scenario bank.");
+    }
+
+    m_scenario = scenario % m_scenarioBank->GetGameCount();
+    m_appleCursor = 0;
+    m_rndEng.seed(m_scenarioBank->GetGameSeed(m_scenario));
+
+    m_steps = 0;
+    m_totalSteps = 0;
+    m_score = 0;
+    m_snake.clear();
+    m_gameState = SnakeGameState::kSnakeGameStateRunning;
+    m_direction = SnakeDirection::kSnakeDirUp;
+
+    Position  snakeHead = m_scenarioBank->GetStartPosition(m_scenario);
+
+    // Add snake head.
+    m_snake.emplace_back(snakeHead);
+
+    // Add snake body.
+    snakeHead.y++;
+    m_snake.emplace_back(snakeHead);
+
+    ClearBoard();
+    RenderSnake();
+    PlaceApple();
+    RenderApple();
+}
+
+
 std::vector<double> SnakeGame::GetParameters()
 {
-    std::vector<double>  params;
+    return ComposeParameters(GetParameterState());
+}
+
+
+std::size_t SnakeGame::GetStateCount() const
+{
+    // Safety combinations * head positions * apple directions * snake directions.
+    return std::size_t(16) * m_boardWidth * m_boardHeight * 3 * 3 * 4;
+}
+
+
+std::size_t SnakeGame::GetStateIndex() const
+{
+    auto state = GetParameterState();
+
+    std::size_t index = state.safety;
+    index = index * m_boardHeight + state.y;
+    index = index * m_boardWidth  + state.x;
+    index = index * 3 + state.appleV;
+    index = index * 3 + state.appleH;
+    index = index * 4 + static_cast<std::size_t>(state.direction);
+
+    return index;
+}
+
+
+SnakeGame::ParameterState SnakeGame::GetParameterState() const
+{
+    ParameterState  state{};
 
     Position snakeHeadPos = m_snake.front();
     int x = snakeHeadPos.x;
     int y = snakeHeadPos.y;
 
-    auto IsPositionSafe = [&](int x, int y)
-    {
-        return x >= 0 && y >= 0 && x < m_boardWidth && y < m_boardHeight &&
-               (m_board[y][x] == BoardObjType::kBoardObjEmpty || m_board[y][x] == BoardObjType::kBoardObjApple);
-    };
+    // Are surrounding blocks safe to move?
+    state.safety = (IsPositionSafe(x, y-1) ? 1 : 0) |
+                   (IsPositionSafe(x, y+1) ? 2 : 0) |
+                   (IsPositionSafe(x-1, y) ? 4 : 0) |
+                   (IsPositionSafe(x+1, y) ? 8 : 0);
+
+    state.x = x;
+    state.y = y;
+
+    // Direction to apple from snake's head.
+    state.appleV = m_applePos.y < y ? 1 : (m_applePos.y > y ? 2 : 0);
+    state.appleH = m_applePos.x < x ? 1 : (m_applePos.x > x ? 2 : 0);
+
+    state.direction = m_direction;
+
+    return state;
+}
+
+
+std::vector<double> SnakeGame::ComposeParameters(const ParameterState & state) const
+{
+    std::vector<double>  params;
+
+    int x = state.x;
+    int y = state.y;
 
     // Are surrounding blocks safe to move? (4 parameters)
-    double isN = IsPositionSafe(x, y-1) ? 1 : 0;
-    double isS = IsPositionSafe(x, y+1) ? 1 : 0;
-    double isW = IsPositionSafe(x-1, y) ? 1 : 0;
-    double isE = IsPositionSafe(x+1, y) ? 1 : 0;
+    double isN = (state.safety & 1) ? 1 : 0;
+    double isS = (state.safety & 2) ? 1 : 0;
+    double isW = (state.safety & 4) ? 1 : 0;
+    double isE = (state.safety & 8) ? 1 : 0;
 
     // Distance from snake's head to boarder of the game boards. (4 parameters)
     double dN = y;
@@ -140,10 +268,10 @@ std::vector<double> SnakeGame::GetParameters()
     double dE = m_boardWidth - 1 - x;
 
     // Direction to apple from snake's head. (4 parameters)
-    double aN = m_applePos.y < y ? 1 : 0;
-    double aS = m_applePos.y > y ? 1 : 0;
-    double aW = m_applePos.x < x ? 1 : 0;
-    double aE = m_applePos.x > x ? 1 : 0;
+    double aN = state.appleV == 1 ? 1 : 0;
+    double aS = state.appleV == 2 ? 1 : 0;
+    double aW = state.appleH == 1 ? 1 : 0;
+    double aE = state.appleH == 2 ? 1 : 0;
 
     // Snake's current moving direction.  (4 parameters)
     double snakesDirUp    = 0;
@@ -151,7 +279,7 @@ std::vector<double> SnakeGame::GetParameters()
     double snakesDirLeft  = 0;
     double snakesDirRight = 0;
 
-    switch (m_direction)
+    switch (state.direction)
     {
         case SnakeDirection::kSnakeDirUp:    snakesDirUp    = 1;  break;
         case SnakeDirection::kSnakeDirDown:  snakesDirDown  = 1;  break;
@@ -180,6 +308,13 @@ std::vector<double> SnakeGame::GetParameters()
 }
 
 
+bool SnakeGame::IsPositionSafe(int x, int y) const
+{
+    return x >= 0 && y >= 0 && x < m_boardWidth && y < m_boardHeight &&
+           (m_board[y][x] == BoardObjType::kBoardObjEmpty || m_board[y][x] == BoardObjType::kBoardObjApple);
+}
+
+
 int SnakeGame::GetRandomNumber(int min, int max)
 {
     return std::uniform_int_distribution<int>(min, max)(m_rndEng);
@@ -228,6 +363,23 @@ void SnakeGame::RenderApple()
 
 bool SnakeGame::PlaceApple()
 {
+    // Take the next empty candidate of the scenario. The board is scanned only if all candidates are used.
+    if (m_scenarioBank)
+    {
+        auto appleCells = m_scenarioBank->GetAppleCells(m_scenario);
+        while (m_appleCursor < appleCells.size())
+        {
+            int cell = appleCells[m_appleCursor++];
+            int x = cell % m_boardWidth;
+            int y = cell / m_boardWidth;
+            if (m_board[y][x] == BoardObjType::kBoardObjEmpty)
+            {
+                m_applePos = Position(x, y);
+                return true;
+            }
+        }
+    }
+
     std::vector<Position>  emptySpots;  // Holds empty spots on the game board.
 
     for (int y=0; y<m_boardHeight; ++y)
@@ -12,8 +12,11 @@
 // Project includes
 // External includes
 // System includes
+#include <cstdint>
 #include <list>
 #include <random>
+#include <span>
+#include <stdexcept>
 #include <vector>
 
 
@@ -53,6 +56,70 @@ struct Position
 };
 
 
+// Pre-generated random content of a fixed set of games. Each game (scenario) has a start position and a sequence of
+// apple candidate cells. Games played on the same scenario get the same random numbers, so all individuals are
+// compared on identical games. The bank is read-only once created and can be shared by many threads.
+class SnakeScenarioBank
+{
+public:
+    // Maximum memory size (bytes) of a bank.
+    static constexpr std::size_t  kMaxMemorySize = std::size_t(256) * 1024 * 1024;
+
+    // Constructor. Creates scenarios of the given number of games from the seed. Throws if the bank would need more
+    // than kMaxMemorySize.
+    SnakeScenarioBank(int boardWidth, int boardHeight, std::size_t gameCount, uint64_t seed);
+
+    // Returns memory size (bytes) of a bank of the given number of games.
+    static std::size_t GetMemorySize(int boardWidth, int boardHeight, std::size_t gameCount)
+    {
+        return gameCount * (sizeof(Position) + GetApplesPerGame(boardWidth, boardHeight) * sizeof(uint16_t));
+    }
+
+    int GetBoardWidth() const       { return m_boardWidth; }
+    int GetBoardHeight() const      { return m_boardHeight; }
+
+    // Returns number of games in the bank.
+    std::size_t GetGameCount() const
+    {
+        return m_startPositions.size();
+    }
+
+    // Returns snake's start position of the game.
+    const Position & GetStartPosition(std::size_t game) const
+    {
+        return m_startPositions[game];
+    }
+
+    // Returns apple candidate cells (y * boardWidth + x) of the game in placement order.
+    std::span<const uint16_t> GetAppleCells(std::size_t game) const
+    {
+        return {m_appleCells.data() + game * m_applesPerGame, m_applesPerGame};
+    }
+
+    // Returns seed of the game that is used if apple candidates of the game run out.
+    uint64_t GetGameSeed(std::size_t game) const
+    {
+        return m_seed + game;
+    }
+
+private:
+    // Rejected candidates are skipped during the game. Twice the board size is enough for most games and the game
+    // falls back to the regular placement if they run out.
+    static std::size_t GetApplesPerGame(int boardWidth, int boardHeight)
+    {
+        return std::size_t(boardWidth) * boardHeight * 2;
+    }
+
+private:
+    int  m_boardWidth;
+    int  m_boardHeight;
+    uint64_t  m_seed;
+    std::size_t  m_applesPerGame;
+    std::vector<Position>  m_startPositions;
+    std::vector<uint16_t>  m_appleCells;    // Apple candidates of all games in one contiguous array.
+};
+
+
 class SnakeGame
 {
 public:
@@ -72,6 +139,23 @@ public:
         Reset();
     }
 
+    // Constructor. Games are played on the scenarios of the bank in order starting from the given scenario. The bank
+    // must outlive the game.
+    explicit SnakeGame(const SnakeScenarioBank & scenarioBank, std::size_t firstScenario = 0) :
+            m_boardWidth{scenarioBank.GetBoardWidth()},
+            m_boardHeight{scenarioBank.GetBoardHeight()},
+            m_direction{SnakeDirection::kSnakeDirUp},
+            m_gameState{SnakeGameState::kSnakeGameStateInvalid},
+            m_score{0},
+            m_steps{0},
+            m_scenarioBank{&scenarioBank}
+    {
+        // Initialize board 2D game board.
+        m_board.resize(m_boardHeight, std::vector<BoardObjType>(m_boardWidth, BoardObjType::kBoardObjEmpty));
+
+        Reset(firstScenario);
+    }
+
     // Returns 2D Game board.
     BoardObjType GetBoardObject(int x, int y)
     {
@@ -106,7 +190,7 @@ public:
         return m_score;
     }
 
-    SnakeGameState GetGameState()
+    SnakeGameState GetGameState() const
     {
         return m_gameState;
     }
@@ -114,9 +198,12 @@ public:
     // Move snake and check environment.
     void Update();
 
-    // Resets game into initial state.
+    // Resets game into initial state. Starts the next scenario if the game is played on a scenario bank.
     void Reset();
 
+    // Resets game into initial state of the given scenario of the scenario bank.
+    void Reset(std::size_t scenario);
+
     // Returns parameter size that can be used in AI model training.
     static std::size_t GetParameterSize()
     {
@@ -126,6 +213,12 @@ public:
     // Returns parameters that can be used in AI model training.
     std::vector<double> GetParameters();
 
+    // Returns number of distinct parameter combinations GetParameters() can return on this board.
+    std::size_t GetStateCount() const;
+
+    // Returns index of the current parameter combination in [0, GetStateCount()).
+    std::size_t GetStateIndex() const;
+
     // Returns distance from snake heads to apple.
     double GetDistanceToApple();
 
@@ -135,7 +228,33 @@ public:
         return m_steps;
     }
 
+    // Returns number of steps since the game started.
+    std::size_t GetTotalSteps() const
+    {
+        return m_totalSteps;
+    }
+
 private:
+    // Discrete game state that determines all parameters returned by GetParameters().
+    struct ParameterState
+    {
+        int  safety;        // Safety bits of north, south, west and east blocks. (16 combinations)
+        int  x;             // Snake's head position.
+        int  y;
+        int  appleV;        // Apple's vertical direction: 0 = same row, 1 = north, 2 = south.
+        int  appleH;        // Apple's horizontal direction: 0 = same column, 1 = west, 2 = east.
+        SnakeDirection  direction;
+    };
+
+    // Returns the discrete state of the current game.
+    ParameterState GetParameterState() const;
+
+    // Returns AI model parameters of a discrete state.
+    std::vector<double> ComposeParameters(const ParameterState & state) const;
+
+    // Returns true if the snake can move into the position.
+    bool IsPositionSafe(int x, int y) const;
+
     // Return a random number between min and max.
     int GetRandomNumber(int min, int max);
 
@@ -165,6 +284,10 @@ private:
     Position  m_applePos;
     int m_score;
     std::size_t  m_steps;
+    std::size_t  m_totalSteps{0};
     std::mt19937_64   m_rndEng;
+    const SnakeScenarioBank *  m_scenarioBank{nullptr};
+    std::size_t  m_scenario{0};
+    std::size_t  m_appleCursor{0};      // Next apple candidate of the scenario.
     static const std::size_t  m_parameterSize{16};
 };
@@ -0,0 +1,281 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+// Project includes
+#include "SnakeSimulator.hpp"
+#include "PerfCounters.hpp"
+#include "Trace.hpp"
+// External includes
+// System includes
+#include <algorithm>
+#include <future>
+
+
+namespace
+{
+
+// Marks policy table entries that are not filled yet.
+constexpr uint8_t  kPolicyTableEmpty = 0xFF;
+
+// Minimum number of games played by a task when games of a model are split across threads.
+constexpr std::size_t  kMinGamesPerTask = 25;
+
+}
+
+
+void SnakeGameStats::Add(const SnakeGame & snakeGame)
+{
+    auto gameState = snakeGame.GetGameState();
+
+    if (gameState == SnakeGameState::kSnakeGameStateFailedHitWall ||
+        gameState == SnakeGameState::kSnakeGameStateFailedHitItself)
+    {
+        deaths++;
+    }
+    if (gameState == SnakeGameState::kSnakeGameStateFailedLongLoop)
+    {
+        longLoopFails++;
+    }
+
+    highestScore = std::max<std::size_t>(highestScore, snakeGame.GetScore());
+    totalSteps += snakeGame.GetSteps();
+    gameSteps += snakeGame.GetTotalSteps();
+    totalScore += snakeGame.GetScore();
+    games++;
+}
+
+
+void SnakeGameStats::Merge(const SnakeGameStats & other)
+{
+    games += other.games;
+    highestScore = std::max(highestScore, other.highestScore);
+    totalScore += other.totalScore;
+    totalSteps += other.totalSteps;
+    gameSteps += other.gameSteps;
+    deaths += other.deaths;
+    longLoopFails += other.longLoopFails;
+    forwardCalls += other.forwardCalls;
+}
+
+
+double SnakeGameStats::GetFitness() const
+{
+    // Fitness formula is very important.
+    double avgSteps = double(totalSteps) / double(games);
+    double avgDeaths = double(deaths) / double(games);
+    double avgLongLoopFails = double(longLoopFails) / double(games);
+    double avgScore = double(totalScore) / double(games);
+
+    return double(highestScore) * 500 + avgScore * 50 - avgDeaths * 15 - avgSteps * 10 - avgLongLoopFails * 100;
+}
+
+
+SnakeSimulator::SnakeSimulator(int boardWidth, int boardHeight, std::size_t gameCount, uint64_t seed) :
+        m_scenarioBank(boardWidth, boardHeight, gameCount, seed)
+{
+}
+
+
+FFNN SnakeSimulator::CreateFFNN()
+{
+    // First determine genetic vector size.
+    int modelInputSize = static_cast<int>(SnakeGame::GetParameterSize());
+
+    std::vector<int>  ffnnLayers{modelInputSize, modelInputSize, modelInputSize/2, 4};
+
+    std::vector<ActivationType> activations{ActivationType::kActivationTypeTanh,
+                                            ActivationType::kActivationTypeTanh,
+                                            ActivationType::kActivationTypeSigmoid};
+
+    return FFNN(ffnnLayers, activations);
+}
+
+
+std::size_t SnakeSimulator::GetParameterCount()
+{
+    return CreateFFNN().SerializeAllParameters().size();
+}
+
+
+SnakeDirection SnakeSimulator::DetermineSnakeDirection(const Eigen::MatrixXd & outputs, Eigen::Index row)
+{
+    SnakeDirection newDir = SnakeDirection::kSnakeDirUp;
+
+    double maxValue = outputs(row, 0);
+
+    if (maxValue < outputs(row, 1)) { newDir = SnakeDirection::kSnakeDirDown; maxValue = outputs(row, 1); }
+    if (maxValue < outputs(row, 2)) { newDir = SnakeDirection::kSnakeDirLeft; maxValue = outputs(row, 2); }
+    if (maxValue < outputs(row, 3)) { newDir = SnakeDirection::kSnakeDirRight; }
+
+    return newDir;
+}
+
+
+std::vector<uint8_t> SnakeSimulator::CreatePolicyTable(const SnakeGame & snakeGame) const
+{
+    // Compile the model into a direction table indexed by game state if the table fits into the budget. Entries are
+    // filled on the first visit of a state, so every state costs at most one model inference and all later visits
+    // cost a single table lookup.
+    std::vector<uint8_t>  policyTable;
+    if (snakeGame.GetStateCount() <= m_policyTableBudget * 1024)
+    {
+        policyTable.resize(snakeGame.GetStateCount(), kPolicyTableEmpty);
+    }
+
+    return policyTable;
+}
+
+
+void SnakeSimulator::CountGames(const SnakeGameStats & stats) const
+{
+    m_gameCount.fetch_add(stats.games, std::memory_order_relaxed);
+    m_stepCount.fetch_add(stats.gameSteps, std::memory_order_relaxed);
+    m_forwardCallCount.fetch_add(stats.forwardCalls, std::memory_order_relaxed);
+}
+
+
+SnakeSimulatorCounters SnakeSimulator::GetCounters() const
+{
+    return {m_gameCount.load(std::memory_order_relaxed), m_stepCount.load(std::memory_order_relaxed),
+            m_forwardCallCount.load(std::memory_order_relaxed)};
+}
+
+
+void SnakeSimulator::PlaySnakeGames(std::size_t gameCount, FFNN & ffnn, SnakeGame & snakeGame,
+                                    std::vector<uint8_t> & policyTable, SnakeGameStats & stats) const
+{
+    SnakeGameStats  played;
+
+    for (std::size_t i=0; i<gameCount; ++i)
+    {
+        while (!policyTable.empty() && snakeGame.GetGameState() == SnakeGameState::kSnakeGameStateRunning)
+        {
+            auto & direction = policyTable[snakeGame.GetStateIndex()];
+            if (direction == kPolicyTableEmpty)
+            {
+                auto modelInputs = snakeGame.GetParameters();
+                auto inputs = Eigen::Map<Eigen::RowVectorXd>(modelInputs.data(), modelInputs.size());
+                direction = static_cast<uint8_t>(DetermineSnakeDirection(ffnn.Forward(inputs)));
+                played.forwardCalls++;
+            }
+
+            snakeGame.SetDirection(static_cast<SnakeDirection>(direction));
+            snakeGame.Update();
+        }
+
+        while (snakeGame.GetGameState() == SnakeGameState::kSnakeGameStateRunning)
+        {
+            // Get game parameters to use as inputs to neural network model.
+            auto modelInputs = snakeGame.GetParameters();
+            auto inputs = Eigen::Map<Eigen::RowVectorXd>(modelInputs.data(), modelInputs.size());
+
+            // Make prediction and get new snake directions as model outputs.
+            auto outputs = ffnn.Forward(inputs);
+            played.forwardCalls++;
+
+            // Determine the best direction from model outputs. The highest value should be the new direction.
+            snakeGame.SetDirection(DetermineSnakeDirection(outputs));
+
+            // Update game.
+            snakeGame.Update();
+        }
+
+        played.Add(snakeGame);
+
+        snakeGame.Reset();
+    }
+
+    stats.Merge(played);
+    CountGames(played);
+}
+
+
+SnakeGameStats SnakeSimulator::SimulateSnakeGameRange(std::span<const double> genesVector, std::size_t firstGame,
+                                                      std::size_t gameCount) const
+{
+    TraceScope  traceScope("SimulateSnakeGames");
+    PerfScope   perfScope(PerfRegion::kPerfRegionSimulate);
+
+    // Setup a neural network.
+    auto ffnn = CreateFFNN();
+
+    // Set weights and biases coming from the trainer.
+    ffnn.DeserializeAllParameters(genesVector);
+
+    // Create a new snake game.
+    SnakeGame snakeGame(m_scenarioBank, firstGame);
+
+    SnakeGameStats  stats;
+    auto policyTable = CreatePolicyTable(snakeGame);
+
+    // Run the same model N times to assess quality of the model.
+    PlaySnakeGames(gameCount, ffnn, snakeGame, policyTable, stats);
+
+    return stats;
+}
+
+
+double SnakeSimulator::SimulateSnakeGames(std::span<const double> genesVector) const
+{
+    // Return fitness value to tell the trainer how well the neural network has played the game so far.
+    return SimulateSnakeGameRange(genesVector, 0, GetGameCount()).GetFitness();
+}
+
+
+std::vector<double> SnakeSimulator::SimulateSnakeGames(const std::vector<std::span<const double>> & genesVectors,
+                                                       ThreadPool & threadPool) const
+{
+    std::size_t modelCount = genesVectors.size();
+    std::size_t gameCount = GetGameCount();
+    if (modelCount == 0)
+    {
+        return {};
+    }
+
+    // Split games of each model only if models alone can't keep all threads busy. Tasks must be large enough to pay
+    // for their own model and game setup.
+    std::size_t taskCount = (threadPool.GetThreadCount() + modelCount - 1) / modelCount;
+    taskCount = std::max<std::size_t>(std::min(taskCount, gameCount / kMinGamesPerTask), 1);
+
+    std::vector<std::future<SnakeGameStats>>  results;
+    for (std::size_t m=0; m<modelCount; ++m)
+    {
+        for (std::size_t t=0; t<taskCount; ++t)
+        {
+            std::size_t firstGame = t * gameCount / taskCount;
+            std::size_t lastGame  = (t + 1) * gameCount / taskCount;
+
+            results.emplace_back(threadPool.Enqueue([&](std::size_t m, std::size_t firstGame, std::size_t gameCount)
+            {
+                return SimulateSnakeGameRange(genesVectors[m], firstGame, gameCount);
+            }, m, firstGame, lastGame - firstGame));
+        }
+    }
+
+    // Wait until all tasks are finished.
+    for (auto & result : results)
+    {
+        result.wait();
+    }
+
+    // Stats are merged in the same order for any number of tasks. They are integer counters, so the fitness values
+    // don't depend on how the games were split.
+    std::vector<double>  fitnesses;
+    for (std::size_t m=0; m<modelCount; ++m)
+    {
+        SnakeGameStats  stats;
+        for (std::size_t t=0; t<taskCount; ++t)
+        {
+            stats.Merge(results[m * taskCount + t].get());
+        }
+        fitnesses.emplace_back(stats.GetFitness());
+    }
+
+    return fitnesses;
+}
@@ -0,0 +1,125 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#pragma once
+
+// Project includes
+#include "FFNN.hpp"
+#include "SnakeGame.hpp"
+#include "ThreadPool.hpp"
+// External includes
+#include <Eigen/Dense>
+// System includes
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+// Accumulated results of simulated snake games.
+struct SnakeGameStats
+{
+    // Adds the result of a finished game.
+    void Add(const SnakeGame & snakeGame);
+
+    // Adds the accumulated results of other games.
+    void Merge(const SnakeGameStats & other);
+
+    // Returns fitness value of the accumulated games.
+    double GetFitness() const;
+
+    std::size_t  games{0};
+    std::size_t  highestScore{0};
+    std::size_t  totalScore{0};
+    std::size_t  totalSteps{0};
+    std::size_t  deaths{0};
+    std::size_t  longLoopFails{0};
+    std::size_t  gameSteps{0};      // All steps. totalSteps counts only the steps after the last apple of each game.
+    std::size_t  forwardCalls{0};   // Model inferences. Steps decided by a policy table don't need one.
+};
+
+
+// Totals of all games played by a simulator.
+struct SnakeSimulatorCounters
+{
+    uint64_t  games{0};
+    uint64_t  steps{0};
+    uint64_t  forwardCalls{0};
+};
+
+
+// Plays snake games with neural network models to measure their fitness. All models play the games of the same
+// scenario bank, so their fitness values are comparable. A simulator can be used by many threads at the same time.
+class SnakeSimulator
+{
+public:
+    // Constructor. Creates a scenario bank of the given number of games.
+    SnakeSimulator(int boardWidth, int boardHeight, std::size_t gameCount, uint64_t seed);
+
+    // Creates and returns a FFNN object with the model topology that is used by all trainers.
+    static FFNN CreateFFNN();
+
+    // Returns number of model parameters.
+    static std::size_t GetParameterCount();
+
+    // Determine direction of the snake from ML model outputs of the given row.
+    static SnakeDirection DetermineSnakeDirection(const Eigen::MatrixXd & outputs, Eigen::Index row = 0);
+
+    // Sets maximum size (KB) of the policy table of a model. Models are compiled into policy tables while playing if
+    // the table fits into the budget. Zero disables policy tables.
+    void SetPolicyTableBudget(std::size_t budget)
+    {
+        m_policyTableBudget = budget;
+    }
+
+    // Returns scenario bank of the simulated games.
+    const SnakeScenarioBank & GetScenarioBank() const
+    {
+        return m_scenarioBank;
+    }
+
+    // Returns number of games played to measure fitness of a model.
+    std::size_t GetGameCount() const
+    {
+        return m_scenarioBank.GetGameCount();
+    }
+
+    // Adds results of games played outside of the simulator to its counters.
+    void CountGames(const SnakeGameStats & stats) const;
+
+    // Returns totals of all games played so far.
+    SnakeSimulatorCounters GetCounters() const;
+
+    // Creates an empty policy table for the game if the table fits into the budget. Otherwise, returns an empty vector.
+    std::vector<uint8_t> CreatePolicyTable(const SnakeGame & snakeGame) const;
+
+    // Plays the given number of games and adds their results to the stats. The policy table is used if not empty.
+    void PlaySnakeGames(std::size_t gameCount, FFNN & ffnn, SnakeGame & snakeGame, std::vector<uint8_t> & policyTable,
+                        SnakeGameStats & stats) const;
+
+    // Plays the given range of games of the scenario bank and returns their results.
+    SnakeGameStats SimulateSnakeGameRange(std::span<const double> genesVector, std::size_t firstGame,
+                                          std::size_t gameCount) const;
+
+    // Plays all games and returns fitness value of the model.
+    double SimulateSnakeGames(std::span<const double> genesVector) const;
+
+    // Plays all games with each model on the thread pool and returns their fitness values. If there are fewer models
+    // than threads, games of each model are split across threads and their results are merged.
+    std::vector<double> SimulateSnakeGames(const std::vector<std::span<const double>> & genesVectors,
+                                           ThreadPool & threadPool) const;
+
+private:
+    SnakeScenarioBank  m_scenarioBank;
+    std::size_t  m_policyTableBudget{0};    // In KB.
+
+    mutable std::atomic<uint64_t>  m_gameCount{0};
+    mutable std::atomic<uint64_t>  m_stepCount{0};
+    mutable std::atomic<uint64_t>  m_forwardCallCount{0};
+};
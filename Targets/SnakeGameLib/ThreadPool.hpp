@@ -9,6 +9,10 @@
 
 #pragma once
 
+#include "Trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <vector>
 #include <queue>
 #include <thread>
@@ -17,6 +21,10 @@
 #include <future>
 #include <functional>
 #include <stdexcept>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 
 class ThreadPool
@@ -32,6 +40,32 @@ public:
         }
     }
 
+    // Constructor. Worker threads are allowed to run only on the given CPUs. Affinity is ignored if it's not
+    // supported by the platform or cpus is empty.
+    ThreadPool(size_t maxThreadCount, const std::vector<int> & cpus) : ThreadPool(maxThreadCount)
+    {
+#if defined(__linux__)
+        if (cpus.empty())
+        {
+            return;
+        }
+
+        cpu_set_t  cpuSet;
+        CPU_ZERO(&cpuSet);
+        for (auto cpu : cpus)
+        {
+            CPU_SET(cpu, &cpuSet);
+        }
+
+        for (auto & worker : m_workers)
+        {
+            pthread_setaffinity_np(worker.native_handle(), sizeof(cpuSet), &cpuSet);
+        }
+#else
+        (void)cpus;
+#endif
+    }
+
     // Destructor
     ~ThreadPool()
     {
@@ -47,6 +81,46 @@ public:
         }
     }
 
+    // Returns the CPUs that the process is allowed to run on.
+    static std::vector<int> GetAvailableCpus()
+    {
+        std::vector<int>  cpus;
+#if defined(__linux__)
+        cpu_set_t  cpuSet;
+        CPU_ZERO(&cpuSet);
+        if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0)
+        {
+            for (int cpu=0; cpu<CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &cpuSet))
+                {
+                    cpus.emplace_back(cpu);
+                }
+            }
+        }
+#endif
+        if (cpus.empty())
+        {
+            for (unsigned cpu=0; cpu<std::max(std::thread::hardware_concurrency(), 1u); ++cpu)
+            {
+                cpus.emplace_back(static_cast<int>(cpu));
+            }
+        }
+        return cpus;
+    }
+
+    // Returns number of worker threads.
+    std::size_t GetThreadCount() const
+    {
+        return m_workers.size();
+    }
+
+    // Returns total time (seconds) the worker threads have spent running tasks.
+    double GetBusyTime() const
+    {
+        return static_cast<double>(m_busyTime.load(std::memory_order_relaxed)) * 1e-9;
+    }
+
     // Add new task item to the queue
     template<class F, class... Args>
     auto Enqueue(F&& f, Args&&... args) -> std::future<typename std::invoke_result_t<F, Args...>>
@@ -93,7 +167,14 @@ private:
                 m_taskQueue.pop();
             }
 
-            task();
+            auto startTime = std::chrono::steady_clock::now();
+            {
+                TraceScope  traceScope("Task");
+                task();
+            }
+            auto busyTime = std::chrono::steady_clock::now() - startTime;
+            m_busyTime.fetch_add(static_cast<uint64_t>(std::chrono::nanoseconds(busyTime).count()),
+                                 std::memory_order_relaxed);
         }
     }
 
@@ -103,6 +184,7 @@ private:
     std::vector<std::thread>  m_workers;
     std::mutex  m_queueSync;
     bool        m_exitNow{false};
+    std::atomic<uint64_t>  m_busyTime{0};   // In nanoseconds.
 };
 
 
@@ -0,0 +1,183 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+// Project includes
+#include "Trace.hpp"
+// External includes
+// System includes
+#include <array>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace
+{
+
+// Events are stored in fixed-size chunks, so recorded events never move.
+constexpr std::size_t  kChunkSize = 4096;
+
+// Events of a thread beyond this limit (about 25 MB) are dropped and counted, so long runs can't use up all memory.
+constexpr std::size_t  kMaxChunksPerThread = 256;
+
+struct TraceEvent
+{
+    const char *  name;
+    uint64_t      begin;
+    uint64_t      end;
+};
+
+struct TraceChunk
+{
+    std::array<TraceEvent, kChunkSize>  events;
+    std::atomic<std::size_t>  count{0};     // Published by the owning thread.
+};
+
+// Events of a thread. Only the owning thread writes into it.
+struct ThreadBuffer
+{
+    std::size_t  threadId{0};
+    std::vector<std::unique_ptr<TraceChunk>>  chunks;     // Changed only under g_registrySync.
+    bool  full{false};                                    // All chunks are used, later events are dropped.
+    std::atomic<uint64_t>  droppedEvents{0};              // Published by the owning thread.
+};
+
+std::mutex  g_registrySync;
+std::vector<std::shared_ptr<ThreadBuffer>>  g_threadBuffers;
+
+// Returns buffer of the calling thread.
+ThreadBuffer & GetThreadBuffer()
+{
+    // Buffers are owned by the registry, so events of finished threads are kept until they are saved.
+    thread_local std::shared_ptr<ThreadBuffer>  buffer;
+    if (!buffer)
+    {
+        std::lock_guard<std::mutex>  lock(g_registrySync);
+        buffer = std::make_shared<ThreadBuffer>();
+        buffer->threadId = g_threadBuffers.size() + 1;
+        g_threadBuffers.emplace_back(buffer);
+    }
+    return *buffer;
+}
+
+}
+
+
+void Tracer::Start()
+{
+    {
+        std::lock_guard<std::mutex>  lock(g_registrySync);
+        for (auto & buffer : g_threadBuffers)
+        {
+            buffer->chunks.clear();
+            buffer->full = false;
+            buffer->droppedEvents = 0;
+        }
+    }
+
+    m_startTime = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    m_enabled = true;
+}
+
+
+void Tracer::Stop()
+{
+    m_enabled = false;
+}
+
+
+void Tracer::Record(const char * name, uint64_t begin, uint64_t end)
+{
+    auto & buffer = GetThreadBuffer();
+
+    // Checked before the lock, so threads with full buffers don't wait for each other.
+    if (buffer.full)
+    {
+        buffer.droppedEvents.store(buffer.droppedEvents.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (buffer.chunks.empty() || buffer.chunks.back()->count.load(std::memory_order_relaxed) == kChunkSize)
+    {
+        std::lock_guard<std::mutex>  lock(g_registrySync);
+        if (buffer.chunks.size() >= kMaxChunksPerThread)
+        {
+            buffer.full = true;
+            buffer.droppedEvents.store(1, std::memory_order_relaxed);
+            return;
+        }
+        buffer.chunks.emplace_back(std::make_unique<TraceChunk>());
+    }
+
+    auto & chunk = *buffer.chunks.back();
+    auto index = chunk.count.load(std::memory_order_relaxed);
+    chunk.events[index] = {name, begin, end};
+    chunk.count.store(index + 1, std::memory_order_release);
+}
+
+
+bool Tracer::Save(const std::string & filename)
+{
+    std::ofstream  file(filename, std::ios::trunc);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    // Timestamps are in microseconds with nanosecond fractions.
+    auto WriteMicroseconds = [&](uint64_t ns)
+    {
+        file << ns / 1000 << "." << static_cast<char>('0' + ns / 100 % 10) << static_cast<char>('0' + ns / 10 % 10)
+             << static_cast<char>('0' + ns % 10);
+    };
+
+    std::lock_guard<std::mutex>  lock(g_registrySync);
+
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto & buffer : g_threadBuffers)
+    {
+        if (buffer->chunks.empty())
+        {
+            continue;
+        }
+
+        file << (first ? "" : ",\n") << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->threadId
+             << R"(,"args":{"name":"Thread )" << buffer->threadId << "\"}}";
+        first = false;
+
+        // Events dropped because the buffer of the thread was full.
+        auto droppedEvents = buffer->droppedEvents.load(std::memory_order_relaxed);
+        if (droppedEvents > 0)
+        {
+            file << ",\n" << R"({"name":"dropped_events","ph":"M","pid":1,"tid":)" << buffer->threadId
+                 << R"(,"args":{"count":)" << droppedEvents << "}}";
+        }
+
+        for (const auto & chunk : buffer->chunks)
+        {
+            auto count = chunk->count.load(std::memory_order_acquire);
+            for (std::size_t i=0; i<count; ++i)
+            {
+                const auto & event = chunk->events[i];
+                file << ",\n" << R"({"name":")" << event.name << R"(","ph":"X","pid":1,"tid":)" << buffer->threadId
+                     << ",\"ts\":";
+                WriteMicroseconds(event.begin);
+                file << ",\"dur\":";
+                WriteMicroseconds(event.end - event.begin);
+                file << "}";
+            }
+        }
+    }
+    file << "\n]}\n";
+
+    return static_cast<bool>(file);
+}
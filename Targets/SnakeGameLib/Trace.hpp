@@ -0,0 +1,89 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#pragma once
+
+// Project includes
+// External includes
+// System includes
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+
+// Records timed events of all threads and saves them in Chrome Trace Event format, which chrome://tracing and
+// Perfetto can open. Each thread records into its own buffer without locks. Recording is disabled by default and
+// costs a single flag check per scope while disabled.
+class Tracer
+{
+public:
+    // Starts recording. Events recorded before are discarded. Must be called when no traced scope is running.
+    static void Start();
+
+    // Stops recording. Scopes that are open keep recording until they end.
+    static void Stop();
+
+    // Returns true if events are being recorded.
+    static bool IsEnabled()
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    // Saves recorded events into a JSON file. Must be called after Stop() when no traced scope is running.
+    // Returns false if the file can't be written.
+    static bool Save(const std::string & filename);
+
+    // Returns the time (ns) since recording started.
+    static uint64_t GetTime()
+    {
+        return ToTraceTime(std::chrono::steady_clock::now());
+    }
+
+    // Converts a time point to the time (ns) since recording started.
+    static uint64_t ToTraceTime(std::chrono::steady_clock::time_point timePoint)
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                timePoint.time_since_epoch()).count()) - m_startTime.load(std::memory_order_relaxed);
+    }
+
+    // Records an event of the calling thread. The name must be a string literal.
+    static void Record(const char * name, uint64_t begin, uint64_t end);
+
+private:
+    static inline std::atomic<bool>      m_enabled{false};
+    static inline std::atomic<uint64_t>  m_startTime{0};
+};
+
+
+// Records an event from construction to destruction if the tracer is enabled. The name must be a string literal.
+class TraceScope
+{
+public:
+    explicit TraceScope(const char * name) : m_name{name}, m_begin{Tracer::IsEnabled() ? Tracer::GetTime() : kDisabled}
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (m_begin != kDisabled)
+        {
+            Tracer::Record(m_name, m_begin, Tracer::GetTime());
+        }
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope & operator=(const TraceScope &) = delete;
+
+private:
+    static constexpr uint64_t  kDisabled = UINT64_MAX;
+
+    const char *  m_name;
+    uint64_t      m_begin;
+};
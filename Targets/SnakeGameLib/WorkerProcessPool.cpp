@@ -0,0 +1,390 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+// Project includes
+#include "WorkerProcessPool.hpp"
+#include "Trace.hpp"
+// External includes
+// System includes
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#define WORKER_PROCESSES_SUPPORTED
+#endif
+
+
+namespace
+{
+
+// Number of tasks a worker holds at once. A small depth keeps the load balanced.
+constexpr std::size_t  kRingDepth = 2;
+
+// Sleep time of an idle process between two polls.
+constexpr long  kPollIntervalNs = 50000;
+
+void SleepPollInterval()
+{
+#if defined(WORKER_PROCESSES_SUPPORTED)
+    timespec  interval{0, kPollIntervalNs};
+    nanosleep(&interval, nullptr);
+#endif
+}
+
+// Returns the size (bytes) of the address space of the calling process, or zero if it's not known. It's called in
+// forked workers, so it reads with system calls only.
+std::size_t GetAddressSpaceSize()
+{
+#if defined(__linux__)
+    int fd = open("/proc/self/statm", O_RDONLY);
+    if (fd < 0)
+    {
+        return 0;
+    }
+
+    char  text[64]{};
+    auto size = read(fd, text, sizeof(text) - 1);
+    close(fd);
+    if (size <= 0)
+    {
+        return 0;
+    }
+
+    // The first field is the size in pages.
+    std::size_t pages = 0;
+    for (const char * c = text; *c >= '0' && *c <= '9'; ++c)
+    {
+        pages = pages * 10 + static_cast<std::size_t>(*c - '0');
+    }
+    return pages * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+}
+
+
+// Shared memory layout: segment header, one ring per worker, then genomes (capacity x genomeLength) and task results
+// (capacity).
+struct WorkerProcessPool::Segment
+{
+    // Task ring of a worker. Only the master writes writePos and only the worker writes readPos.
+    struct alignas(64) Ring
+    {
+        std::atomic<uint64_t>  writePos{0};
+        alignas(64) std::atomic<uint64_t>  readPos{0};
+        uint64_t  tasks[kRingDepth]{};
+    };
+
+    std::atomic<uint32_t>  shutdown{0};
+
+    // Returns the offset of a worker's ring from the start of the segment.
+    static std::size_t GetRingOffset(std::size_t worker)
+    {
+        std::size_t firstRingOffset = (sizeof(Segment) + alignof(Ring) - 1) / alignof(Ring) * alignof(Ring);
+        return firstRingOffset + sizeof(Ring) * worker;
+    }
+
+    static std::size_t GetHeaderSize(std::size_t workerCount)
+    {
+        return GetRingOffset(workerCount);
+    }
+
+    // Returns the ring of a worker. Rings are constructed in the segment right after the header.
+    Ring & GetRing(std::size_t worker)
+    {
+        return *std::launder(reinterpret_cast<Ring *>(reinterpret_cast<char *>(this) + GetRingOffset(worker)));
+    }
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared memory rings require lock-free 64-bit atomics.");
+
+
+WorkerProcessPool::WorkerProcessPool(std::size_t workerCount, std::size_t capacity, std::size_t genomeLength,
+                                     std::function<EvaluationResult(std::span<const double> value)> fitnessFunc,
+                                     std::size_t memoryLimit) :
+        m_workerCount{std::max<std::size_t>(workerCount, 1)},
+        m_capacity{std::max<std::size_t>(capacity, 1)},
+        m_genomeLength{genomeLength},
+        m_memoryLimit{memoryLimit},
+        m_fitnessFunc{std::move(fitnessFunc)}
+{
+#if defined(WORKER_PROCESSES_SUPPORTED)
+    std::size_t headerSize = Segment::GetHeaderSize(m_workerCount);
+    m_segmentSize = headerSize + m_capacity * m_genomeLength * sizeof(double) + m_capacity * sizeof(EvaluationResult);
+
+    // The segment is unlinked right after it's mapped. Workers inherit the mapping and nothing is left behind even if
+    // the processes are killed.
+    std::string  name = "/snakeai-" + std::to_string(getpid());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Can't create shared memory segment " + name);
+    }
+    shm_unlink(name.c_str());
+
+    void * memory = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(m_segmentSize)) == 0)
+    {
+        memory = mmap(nullptr, m_segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+
+    if (memory == MAP_FAILED)
+    {
+        throw std::runtime_error("Can't map shared memory segment " + name);
+    }
+
+    m_segment = new (memory) Segment;
+    for (std::size_t w=0; w<m_workerCount; ++w)
+    {
+        new (static_cast<char *>(memory) + Segment::GetRingOffset(w)) Segment::Ring;
+    }
+    m_genomes = reinterpret_cast<double *>(static_cast<char *>(memory) + headerSize);
+    m_results = reinterpret_cast<EvaluationResult *>(m_genomes + m_capacity * m_genomeLength);
+
+    m_masterPid = getpid();
+    m_workerPids.resize(m_workerCount, -1);
+    for (std::size_t w=0; w<m_workerCount; ++w)
+    {
+        StartWorker(w);
+    }
+#else
+    throw std::runtime_error("Worker processes are not supported on this platform.");
+#endif
+}
+
+
+WorkerProcessPool::~WorkerProcessPool()
+{
+#if defined(WORKER_PROCESSES_SUPPORTED)
+    StopWorkers();
+    munmap(m_segment, m_segmentSize);
+#endif
+}
+
+
+std::vector<EvaluationResult> WorkerProcessPool::Evaluate(const std::vector<std::span<const double>> & genomes)
+{
+    std::lock_guard<std::mutex>  lock(m_evaluateSync);
+    TraceScope  traceScope("EvaluateInWorkerProcesses");
+
+    std::vector<EvaluationResult>  results(genomes.size());
+    for (std::size_t first=0; first<genomes.size(); first += m_capacity)
+    {
+        std::size_t count = std::min(m_capacity, genomes.size() - first);
+        EvaluateChunk(std::span(genomes).subspan(first, count), std::span(results).subspan(first, count));
+    }
+
+    return results;
+}
+
+
+void WorkerProcessPool::EvaluateChunk(std::span<const std::span<const double>> genomes,
+                                      std::span<EvaluationResult> results)
+{
+#if defined(WORKER_PROCESSES_SUPPORTED)
+    for (std::size_t t=0; t<genomes.size(); ++t)
+    {
+        if (genomes[t].size() != m_genomeLength)
+        {
+            throw std::runtime_error("Genome length does not match the worker process pool.");
+        }
+        std::copy(genomes[t].begin(), genomes[t].end(), m_genomes + t * m_genomeLength);
+    }
+
+    // Tasks that are not given to any worker yet. Tasks of crashed workers are put back here.
+    std::vector<uint64_t>  queue(genomes.size());
+    for (std::size_t t=0; t<queue.size(); ++t)
+    {
+        queue[t] = queue.size() - 1 - t;    // Tasks are taken from the back.
+    }
+
+    std::vector<uint64_t>  completedPos(m_workerCount);
+    for (std::size_t w=0; w<m_workerCount; ++w)
+    {
+        completedPos[w] = m_segment->GetRing(w).readPos.load(std::memory_order_acquire);
+    }
+
+    std::size_t doneCount = 0;
+    while (doneCount < genomes.size())
+    {
+        bool progress = false;
+
+        for (std::size_t w=0; w<m_workerCount; ++w)
+        {
+            auto & ring = m_segment->GetRing(w);
+
+            // Collect results of the finished tasks.
+            auto CollectResults = [&]()
+            {
+                uint64_t readPos = ring.readPos.load(std::memory_order_acquire);
+                for (; completedPos[w] < readPos; ++completedPos[w])
+                {
+                    auto task = ring.tasks[completedPos[w] % kRingDepth];
+                    results[task] = m_results[task];
+                    doneCount++;
+                    progress = true;
+                }
+                return readPos;
+            };
+            uint64_t readPos = CollectResults();
+
+            // Restart the worker if it has exited. The worker may have finished more tasks since the results were
+            // collected, so they are collected again first. The task it was running is the one at the read position.
+            int status = 0;
+            if (waitpid(m_workerPids[w], &status, WNOHANG) == m_workerPids[w])
+            {
+                readPos = CollectResults();
+                uint64_t writePos = ring.writePos.load(std::memory_order_relaxed);
+                if (readPos < writePos)
+                {
+                    EvaluationResult  failed;
+                    failed.fitness = std::numeric_limits<double>::lowest();
+                    results[ring.tasks[readPos % kRingDepth]] = failed;
+                    doneCount++;
+                    m_failureCount++;
+
+                    for (uint64_t pos=readPos+1; pos<writePos; ++pos)
+                    {
+                        queue.emplace_back(ring.tasks[pos % kRingDepth]);
+                    }
+                }
+
+                ring.writePos.store(0, std::memory_order_relaxed);
+                ring.readPos.store(0, std::memory_order_relaxed);
+                completedPos[w] = 0;
+
+                StartWorker(w);
+                progress = true;
+                continue;
+            }
+
+            // Give new tasks to the worker.
+            uint64_t writePos = ring.writePos.load(std::memory_order_relaxed);
+            while (!queue.empty() && writePos - readPos < kRingDepth)
+            {
+                ring.tasks[writePos % kRingDepth] = queue.back();
+                queue.pop_back();
+                ring.writePos.store(++writePos, std::memory_order_release);
+                progress = true;
+            }
+        }
+
+        if (!progress)
+        {
+            SleepPollInterval();
+        }
+    }
+#else
+    (void)genomes;
+    (void)results;
+#endif
+}
+
+
+void WorkerProcessPool::StartWorker(std::size_t worker)
+{
+#if defined(WORKER_PROCESSES_SUPPORTED)
+    int pid = fork();
+    if (pid < 0)
+    {
+        throw std::runtime_error("Can't start a worker process.");
+    }
+
+    if (pid == 0)
+    {
+        RunWorker(worker);
+    }
+
+    m_workerPids[worker] = pid;
+#else
+    (void)worker;
+#endif
+}
+
+
+void WorkerProcessPool::RunWorker(std::size_t worker)
+{
+#if defined(WORKER_PROCESSES_SUPPORTED)
+    // Only the master handles termination requests.
+    signal(SIGTERM, SIG_IGN);
+    signal(SIGINT, SIG_IGN);
+
+    // The worker inherits the address space of the master, including the stacks of its threads and the memory of
+    // the simulator, so the limit is the headroom above the address space at fork time.
+    if (m_memoryLimit > 0)
+    {
+        rlimit  limit{};
+        limit.rlim_cur = limit.rlim_max = static_cast<rlim_t>(GetAddressSpaceSize() + m_memoryLimit * 1024 * 1024);
+        setrlimit(RLIMIT_AS, &limit);
+    }
+
+    auto & ring = m_segment->GetRing(worker);
+
+    // Any exception ends the worker, and the master treats it as a crash of the current task. The worker never
+    // returns into the code of the master, so exit skips destructors of the objects copied from it.
+    try
+    {
+        while (!m_segment->shutdown.load(std::memory_order_acquire))
+        {
+            uint64_t readPos = ring.readPos.load(std::memory_order_relaxed);
+            if (readPos == ring.writePos.load(std::memory_order_acquire))
+            {
+                // Exit if the master is gone.
+                if (getppid() != m_masterPid)
+                {
+                    break;
+                }
+                SleepPollInterval();
+                continue;
+            }
+
+            auto task = ring.tasks[readPos % kRingDepth];
+            m_results[task] = m_fitnessFunc({m_genomes + task * m_genomeLength, m_genomeLength});
+            ring.readPos.store(readPos + 1, std::memory_order_release);
+        }
+    }
+    catch (...)
+    {
+        _exit(1);
+    }
+
+    _exit(0);
+#else
+    (void)worker;
+    throw std::runtime_error("Worker processes are not supported on this platform.");
+#endif
+}
+
+
+void WorkerProcessPool::StopWorkers()
+{
+#if defined(WORKER_PROCESSES_SUPPORTED)
+    m_segment->shutdown.store(1, std::memory_order_release);
+    for (auto pid : m_workerPids)
+    {
+        if (pid > 0)
+        {
+            waitpid(pid, nullptr, 0);
+        }
+    }
+#endif
+}
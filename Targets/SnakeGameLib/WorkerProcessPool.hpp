@@ -0,0 +1,87 @@
+//
+//  Copyright © 2023-Present, Arkin Terli. All rights reserved.
+//
+//  NOTICE:  All information contained herein is, and remains the property of Arkin Terli.
+//  The intellectual and technical concepts contained herein are proprietary to Arkin Terli
+//  and may be covered by U.S. and Foreign Patents, patents in process, and are protected by
+//  trade secret or copyright law. Dissemination of this information or reproduction of this
+//  material is strictly forbidden unless prior written permission is obtained from Arkin Terli.
+
+#pragma once
+
+// Project includes
+#include "EvaluationResult.hpp"
+// External includes
+// System includes
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <vector>
+
+
+// Evaluates a fitness function in forked worker processes. Genomes and results are exchanged through a POSIX shared
+// memory segment. Each worker has a lock-free single-producer single-consumer ring of task indices in the same
+// segment, so the master always knows which task a worker is running.
+// A worker that crashes, for example by an assertion or by exceeding its memory limit, is restarted and the task it
+// was running gets the lowest possible fitness and no counters. The rest of its tasks are given to other workers.
+// Workers inherit the memory of the master at the time they are forked, so everything the fitness function uses
+// must be created before the pool and must not change afterwards.
+class WorkerProcessPool
+{
+public:
+    // Constructor. Forks workerCount workers that can evaluate up to capacity genomes of genomeLength values at once.
+    // memoryLimit (MB) limits how much each worker can grow its address space beyond the address space it inherits
+    // from the master. Zero means no limit.
+    WorkerProcessPool(std::size_t workerCount, std::size_t capacity, std::size_t genomeLength,
+                      std::function<EvaluationResult(std::span<const double> value)> fitnessFunc,
+                      std::size_t memoryLimit = 0);
+
+    // Destructor. Stops all workers.
+    ~WorkerProcessPool();
+
+    WorkerProcessPool(const WorkerProcessPool &) = delete;
+    WorkerProcessPool & operator=(const WorkerProcessPool &) = delete;
+
+    // Returns results of the genomes. Thread-safe, concurrent calls are evaluated one after another.
+    std::vector<EvaluationResult> Evaluate(const std::vector<std::span<const double>> & genomes);
+
+    // Returns number of evaluations that crashed their workers so far.
+    std::size_t GetFailureCount() const
+    {
+        return m_failureCount;
+    }
+
+private:
+    struct Segment;
+
+    // Forks the worker at the given index.
+    void StartWorker(std::size_t worker);
+
+    // Worker process main loop. Never returns.
+    [[noreturn]] void RunWorker(std::size_t worker);
+
+    // Evaluates genomes that fit into the segment.
+    void EvaluateChunk(std::span<const std::span<const double>> genomes, std::span<EvaluationResult> results);
+
+    // Stops all workers and waits until they exit.
+    void StopWorkers();
+
+private:
+    std::size_t  m_workerCount;
+    std::size_t  m_capacity;
+    std::size_t  m_genomeLength;
+    std::size_t  m_memoryLimit;
+    std::function<EvaluationResult(std::span<const double> value)>  m_fitnessFunc;
+
+    Segment *    m_segment{nullptr};
+    std::size_t  m_segmentSize{0};
+    double *     m_genomes{nullptr};
+    EvaluationResult *  m_results{nullptr};
+
+    std::vector<int>  m_workerPids;
+    int          m_masterPid{0};
+    std::size_t  m_failureCount{0};
+    std::mutex   m_evaluateSync;
+};
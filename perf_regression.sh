@@ -0,0 +1,108 @@
+#!/bin/bash
+
+#
+#  Copyright (c) 2024-Present, Arkin Terli. All rights reserved.
+#
+
+# Fixed workload. All runs are seeded, so both builds train and simulate exactly the same games.
+GENERATIONS=20
+BOARD_SIZES=(10 20)
+SAMPLING_COUNT=500
+SEED=1
+
+function showHelp()
+{
+    echo ""
+    echo "Usage:"
+    echo "    $0 <baseline_dir> <candidate_dir> [<runs>] [<threshold>]"
+    echo ""
+    echo "Example:"
+    echo "    $0 product-base product-rel 5 3"
+    echo ""
+    echo "Options:"
+    echo "    baseline_dir     Installation directory of the baseline build."
+    echo "    candidate_dir    Installation directory of the candidate build."
+    echo "    runs             Runs of the workload on each build. Default: 5"
+    echo "    threshold        Maximum allowed throughput drop in percent. Default: 3"
+    echo ""
+    echo "Both builds run the same seeded workload: $GENERATIONS generations of 'ga train' on each board size and"
+    echo "a simulation sweep of a fixed model. Exits with 1 if the candidate is slower than the threshold."
+    echo ""
+    echo "Both builds must support 'ga train --metrics' and '--seed', and 'SnakeAIBench --modelfile'. Older builds"
+    echo "can't be used as the baseline."
+    echo ""
+}
+
+# Exits with an error if the build doesn't support the options the workload uses.
+function checkBuild()
+{
+    bin_dir=$1
+
+    help=$("$bin_dir/SnakeAIApp" ga --help 2>&1)
+    for option in --metrics --seed; do
+        if ! grep -q -e "$option=" <<< "$help"; then
+            echo "$bin_dir/SnakeAIApp doesn't support $option. The build is too old to compare."
+            exit 1
+        fi
+    done
+
+    if ! "$bin_dir/SnakeAIBench" --help 2>&1 | grep -q -e "--modelfile="; then
+        echo "$bin_dir/SnakeAIBench is missing or doesn't support --modelfile. The build is too old to compare."
+        exit 1
+    fi
+}
+
+# Runs the workload once on a build and writes the results into the result folder of the build.
+function runWorkload()
+{
+    bin_dir=$1
+    result_dir=$2
+    run=$3
+
+    for size in "${BOARD_SIZES[@]}"; do
+        "$compare" run --rss="$result_dir/train-${size}x${size}-$run.rss" -- \
+            "$bin_dir/SnakeAIApp" ga train --modelfile="$work_dir/train.mdl" --maxGen=$GENERATIONS \
+            --bw=$size --bh=$size --sc=$SAMPLING_COUNT --seed=$SEED \
+            --metrics="$result_dir/train-${size}x${size}-$run.jsonl" > /dev/null || exit 1
+    done
+
+    "$bin_dir/SnakeAIBench" --filter=SnakeSimulator --repetitions=5 --games=$SAMPLING_COUNT \
+        --modelfile="$work_dir/model.mdl" --output="$result_dir/bench-$run.json" > /dev/null || exit 1
+}
+
+function main()
+{
+    baseline_dir=$(cd "$1" && pwd) || exit 1
+    candidate_dir=$(cd "$2" && pwd) || exit 1
+    runs=${3:-5}
+    threshold=${4:-3}
+    compare="$candidate_dir/SnakeAIPerfCompare"
+
+    checkBuild "$baseline_dir"
+    checkBuild "$candidate_dir"
+
+    work_dir=$(mktemp -d) || exit 1
+    trap 'rm -rf "$work_dir"' EXIT
+    mkdir "$work_dir/baseline" "$work_dir/candidate"
+
+    # The simulation sweep plays a model trained by the baseline, so both builds play identical games.
+    "$baseline_dir/SnakeAIApp" ga train --modelfile="$work_dir/model.mdl" --maxGen=$GENERATIONS \
+        --sc=$SAMPLING_COUNT --seed=$SEED > /dev/null || exit 1
+
+    # Runs of the builds alternate, so that slow changes of the machine affect both builds equally.
+    for ((run=1; run<=runs; run++)); do
+        echo "Run $run of $runs"
+        runWorkload "$baseline_dir" "$work_dir/baseline" $run
+        runWorkload "$candidate_dir" "$work_dir/candidate" $run
+    done
+
+    "$compare" compare --baseline="$work_dir/baseline" --candidate="$work_dir/candidate" --threshold=$threshold \
+        --output=perf_regression.json
+    exit $?
+}
+
+if [ "$#" -ge 2 ]; then
+    main "$@"  # Pass all parameters
+else
+    showHelp
+fi